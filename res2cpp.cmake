@@ -0,0 +1,110 @@
+# res2cpp_add_resources(<target> CONFIG <file>
+#   [HEADER <file>] [SOURCE <file>] [SHARDS <count>]
+#   [NATIVE] [PORTABLE] [RELOCATABLE] [XOR <key>] [DATA <type>]
+#   [TYPE <type>] [ALIAS <type>]
+#   [INCLUDES <file>...] [OPTIONS <argument>...])
+#
+# Generates the header and source files of a res2cpp config and adds
+# them to the target. res2cpp only runs when the config or one of the
+# resources changed, which is tracked using a depfile.
+
+function(res2cpp_add_resources TARGET)
+  cmake_parse_arguments(ARG
+    "NATIVE;PORTABLE;RELOCATABLE"
+    "CONFIG;HEADER;SOURCE;SHARDS;XOR;DATA;TYPE;ALIAS"
+    "INCLUDES;OPTIONS" ${ARGN})
+
+  if(NOT ARG_CONFIG)
+    message(FATAL_ERROR "res2cpp_add_resources: CONFIG is required")
+  endif()
+  get_filename_component(CONFIG "${ARG_CONFIG}" ABSOLUTE)
+  get_filename_component(NAME "${CONFIG}" NAME_WE)
+
+  set(HEADER "${CMAKE_CURRENT_BINARY_DIR}/${NAME}.h")
+  if(ARG_HEADER)
+    get_filename_component(HEADER "${ARG_HEADER}" ABSOLUTE
+      BASE_DIR "${CMAKE_CURRENT_BINARY_DIR}")
+  endif()
+  set(SOURCE "${CMAKE_CURRENT_BINARY_DIR}/${NAME}.cpp")
+  if(ARG_SOURCE)
+    get_filename_component(SOURCE "${ARG_SOURCE}" ABSOLUTE
+      BASE_DIR "${CMAKE_CURRENT_BINARY_DIR}")
+  endif()
+  set(DEPFILE "${CMAKE_CURRENT_BINARY_DIR}/${NAME}.res2cpp.d")
+
+  set(ARGS -c "${CONFIG}" -h "${HEADER}" -s "${SOURCE}" -f "${DEPFILE}")
+  set(SOURCES "${SOURCE}")
+  if(ARG_SHARDS AND ARG_SHARDS GREATER 1)
+    # source files are named like the ones generated by res2cpp
+    list(APPEND ARGS -j ${ARG_SHARDS})
+    get_filename_component(SOURCE_DIR "${SOURCE}" DIRECTORY)
+    get_filename_component(SOURCE_NAME "${SOURCE}" NAME_WE)
+    get_filename_component(SOURCE_EXT "${SOURCE}" EXT)
+    set(SOURCES)
+    math(EXPR LAST "${ARG_SHARDS} - 1")
+    foreach(INDEX RANGE ${LAST})
+      list(APPEND SOURCES "${SOURCE_DIR}/${SOURCE_NAME}_${INDEX}${SOURCE_EXT}")
+    endforeach()
+  endif()
+  if(ARG_NATIVE)
+    list(APPEND ARGS -n)
+  endif()
+  if(ARG_PORTABLE)
+    list(APPEND ARGS -p)
+  endif()
+  if(ARG_RELOCATABLE)
+    list(APPEND ARGS -R)
+  endif()
+  if(ARG_XOR)
+    list(APPEND ARGS -x "${ARG_XOR}")
+  endif()
+  if(ARG_DATA)
+    list(APPEND ARGS -d "${ARG_DATA}")
+  endif()
+  if(ARG_TYPE)
+    list(APPEND ARGS -t "${ARG_TYPE}")
+  endif()
+  if(ARG_ALIAS)
+    list(APPEND ARGS -a "${ARG_ALIAS}")
+  endif()
+  foreach(INCLUDE ${ARG_INCLUDES})
+    list(APPEND ARGS -i "${INCLUDE}")
+  endforeach()
+  list(APPEND ARGS ${ARG_OPTIONS})
+
+  if(TARGET res2cpp)
+    set(RES2CPP $<TARGET_FILE:res2cpp>)
+    set(RES2CPP_DEPENDS res2cpp)
+  else()
+    find_program(RES2CPP_EXECUTABLE res2cpp)
+    if(NOT RES2CPP_EXECUTABLE)
+      message(FATAL_ERROR "res2cpp_add_resources: res2cpp not found")
+    endif()
+    set(RES2CPP "${RES2CPP_EXECUTABLE}")
+    set(RES2CPP_DEPENDS "${RES2CPP_EXECUTABLE}")
+  endif()
+
+  # the depfile is the output, since it is always written, while the
+  # header and sources are only touched when their content changes
+  set(DEPFILE_ARGS)
+  if(CMAKE_GENERATOR MATCHES "Ninja" OR NOT CMAKE_VERSION VERSION_LESS 3.20)
+    set(DEPFILE_ARGS DEPFILE "${DEPFILE}")
+  else()
+    message(WARNING "res2cpp_add_resources: the generator ${CMAKE_GENERATOR} "
+      "does not support depfiles before CMake 3.20, so modifications of "
+      "resources listed in ${ARG_CONFIG} do not trigger a regeneration")
+  endif()
+  add_custom_command(
+    OUTPUT "${DEPFILE}"
+    BYPRODUCTS "${HEADER}" ${SOURCES}
+    COMMAND ${RES2CPP} ${ARGS}
+    DEPENDS "${CONFIG}" ${RES2CPP_DEPENDS}
+    ${DEPFILE_ARGS}
+    COMMENT "Generating resources of ${ARG_CONFIG}"
+    VERBATIM
+  )
+
+  target_sources(${TARGET} PRIVATE "${DEPFILE}" "${HEADER}" ${SOURCES})
+  get_filename_component(HEADER_DIR "${HEADER}" DIRECTORY)
+  target_include_directories(${TARGET} PRIVATE "${HEADER_DIR}")
+endfunction()
@@ -9,6 +9,10 @@
 #include <algorithm>
 #include <cstring>
 #include <map>
+#include <array>
+#include <chrono>
+#include <random>
+#include <functional>
 
 void print_help_message() {
   std::cout <<
@@ -16,6 +20,8 @@ void print_help_message() {
     "\n"
     "Usage: res2cpp [-options]\n"
     "  -c, --config <file>  sets the path of the config file (stdin when not set).\n"
+    "                       can be set multiple times to process a batch.\n"
+    "  -b, --batch <file>   process the config files listed in a file.\n"
     "  -s, --source <file>  sets the path of the source file.\n"
     "  -h, --header <file>  sets the path of the header file.\n"
   //"  -e, --embed          use #embed for embedding files.\n"
@@ -25,6 +31,20 @@ void print_help_message() {
     "  -i, --include <file> add #include to generated header.\n"
     "  -x, --xor <key>      encrypt the data using a simple XOR cipher.\n"
     "  -n, --native         optimize for native endianness to improve compile-time.\n"
+    "  -p, --portable       optimize for compile-time, independent of endianness.\n"
+    "  -r, --dev            load files at runtime instead of embedding them.\n"
+    "  -R, --relocatable    generate identical outputs in every directory.\n"
+    "  -g, --group-headers  generate a header per top-level namespace.\n"
+    "  -k, --digest <type>  declare a digest per resource (fnv1a, crc32).\n"
+    "  -C, --cache-dir <dir>\n"
+    "                       cache encoded data in directory (RES2CPP_CACHE_DIR).\n"
+    "  -M, --cache-size <MiB>\n"
+    "                       limit size of cache directory (default 1024).\n"
+    "  -j, --shards <count> split the source into multiple files.\n"
+    "  -f, --depfile <file> write a Makefile rule with the input files.\n"
+    "  -u, --unused <file>  report resources not referenced in object/map file.\n"
+    "  -D, --define <name>  define a name for selecting conditional sections.\n"
+    "  -z, --stubs          define excluded resources as empty.\n"
     "\n"
     "All Rights Reserved.\n"
     "This program comes with absolutely no warranty.\n"
@@ -33,36 +53,102 @@ void print_help_message() {
 }
 
 struct Settings {
+  std::vector<std::filesystem::path> config_files;
   std::filesystem::path config_file;
   std::filesystem::path source_file;
   std::filesystem::path header_file;
   std::optional<bool> little_endian;
+  bool portable{ };
+  bool dev{ };
+  bool relocatable{ };
   std::string data_type{ "unsigned char" };
   std::string resource_type;
   std::string resource_alias;
   std::vector<std::string> includes;
   std::string xor_key;
+  bool group_headers{ };
+  bool digest_fnv1a{ };
+  bool digest_crc32{ };
+  std::filesystem::path cache_dir;
+  uintmax_t cache_size{ 1024 };
+  int shards{ 1 };
+  std::filesystem::path depfile;
+  std::vector<std::filesystem::path> symbol_files;
+  std::vector<std::string> defines;
+  bool stubs{ };
+};
+
+enum Transform {
+  normalize_eol = 1 << 0,
+  strip_comments = 1 << 1,
+  minify_json = 1 << 2,
+  null_terminate = 1 << 3,
+};
+
+enum class Directive {
+  none,
+  if_defined,
+  if_not_defined,
+  else_branch,
+  end_if,
 };
 
 struct Definition {
   std::string id;
   std::string path;
   bool is_header;
+  int transforms{ };
+  Directive directive{ };
+  std::string condition{ };
 };
 
 struct Resource {
   std::string id;
   std::filesystem::path path;
+  int transforms{ };
+  bool conditional{ };
+  bool stub{ };
 
   friend bool operator<(const Resource& a, const Resource& b) {
-    return std::tie(a.id, a.path) < std::tie(b.id, b.path);
+    return std::tie(a.id, a.path, a.transforms) <
+           std::tie(b.id, b.path, b.transforms);
   }
 };
 
+struct Digest {
+  uint64_t fnv1a{ 0xCBF29CE484222325 };
+  uint32_t crc32{ 0xFFFFFFFF };
+};
+
+struct CachedFile {
+  std::optional<Digest> digest;
+  std::optional<std::string> hexdump;
+  size_t size{ };
+  int uses{ };
+  bool stored{ };
+};
+
+using CacheKey = std::pair<std::filesystem::path, int>;
+using Cache = std::map<CacheKey, CachedFile>;
+
+struct Shard {
+  std::filesystem::path source_file;
+  std::vector<Resource> resources;
+};
+
+struct Condition {
+  bool active;
+  bool has_else;
+};
+
 struct State {
   std::filesystem::path base_path;
+  std::vector<std::string> defines;
+  bool stubs{ };
   std::string id_prefix;
   std::string path_prefix;
+  int transforms{ };
+  std::vector<Condition> conditions;
   std::vector<Resource> resources;
 };
 
@@ -139,6 +225,20 @@ void add_resource(State& state, std::string&& id, std::string&& path) {
   state.resources.push_back({ std::move(id), std::move(path) });
 }
 
+bool deduce_output_files(Settings& settings) {
+  if (settings.source_file.empty()) {
+    if (settings.config_file.empty())
+      return false;
+    settings.source_file = settings.config_file;
+    settings.source_file.replace_extension("cpp");
+  }
+  if (settings.header_file.empty()) {
+    settings.header_file = settings.source_file;
+    settings.header_file.replace_extension("h");
+  }
+  return true;
+}
+
 bool interpret_commandline(Settings& settings, int argc, const char* argv[]) {
   for (auto i = 1; i < argc; i++) {
     const auto argument = std::string_view(argv[i]);
@@ -146,7 +246,22 @@ bool interpret_commandline(Settings& settings, int argc, const char* argv[]) {
     if (argument == "-c" || argument == "--config") {
       if (++i >= argc)
         return false;
-      settings.config_file = utf8_to_path(argv[i]);
+      settings.config_files.push_back(utf8_to_path(argv[i]));
+    }
+    else if (argument == "-b" || argument == "--batch") {
+      if (++i >= argc)
+        return false;
+      const auto filename = utf8_to_path(argv[i]);
+      auto is = std::ifstream(filename);
+      if (!is.good())
+        error("opening batch file '" + path_to_utf8(filename) + "' failed");
+      auto line = std::string{ };
+      while (std::getline(is, line)) {
+        line = trim(line);
+        if (!line.empty() && line.front() != '#')
+          settings.config_files.push_back(
+            filename.parent_path() / utf8_to_path(line));
+      }
     }
     else if (argument == "-s" || argument == "--source") {
       if (++i >= argc)
@@ -166,6 +281,17 @@ bool interpret_commandline(Settings& settings, int argc, const char* argv[]) {
       } native_endianness = { 1 };
 
       settings.little_endian.emplace(native_endianness.little == 1);
+      settings.portable = false;
+    }
+    else if (argument == "-p" || argument == "--portable") {
+      settings.little_endian.emplace(true);
+      settings.portable = true;
+    }
+    else if (argument == "-r" || argument == "--dev") {
+      settings.dev = true;
+    }
+    else if (argument == "-R" || argument == "--relocatable") {
+      settings.relocatable = true;
     }
     else if (argument == "-d" || argument == "--data") {
       if (++i >= argc)
@@ -192,23 +318,77 @@ bool interpret_commandline(Settings& settings, int argc, const char* argv[]) {
         return false;
       settings.xor_key = argv[i];
     }
+    else if (argument == "-g" || argument == "--group-headers") {
+      settings.group_headers = true;
+    }
+    else if (argument == "-C" || argument == "--cache-dir") {
+      if (++i >= argc)
+        return false;
+      settings.cache_dir = utf8_to_path(argv[i]);
+    }
+    else if (argument == "-M" || argument == "--cache-size") {
+      if (++i >= argc)
+        return false;
+      auto ss = std::istringstream(argv[i]);
+      if (!(ss >> settings.cache_size))
+        return false;
+    }
+    else if (argument == "-j" || argument == "--shards") {
+      if (++i >= argc)
+        return false;
+      auto ss = std::istringstream(argv[i]);
+      if (!(ss >> settings.shards) || settings.shards < 1)
+        return false;
+    }
+    else if (argument == "-f" || argument == "--depfile") {
+      if (++i >= argc)
+        return false;
+      settings.depfile = utf8_to_path(argv[i]);
+    }
+    else if (argument == "-u" || argument == "--unused") {
+      if (++i >= argc)
+        return false;
+      settings.symbol_files.push_back(utf8_to_path(argv[i]));
+    }
+    else if (argument == "-D" || argument == "--define") {
+      if (++i >= argc)
+        return false;
+      settings.defines.push_back(argv[i]);
+    }
+    else if (argument == "-z" || argument == "--stubs") {
+      settings.stubs = true;
+    }
+    else if (argument == "-k" || argument == "--digest") {
+      if (++i >= argc)
+        return false;
+      const auto type = std::string_view(argv[i]);
+      if (type == "fnv1a")
+        settings.digest_fnv1a = true;
+      else if (type == "crc32")
+        settings.digest_crc32 = true;
+      else
+        return false;
+    }
     else {
       return false;
     }
   }
 
-  // other paths can be deduced
-  if (settings.source_file.empty()) {
-    if (settings.config_file.empty())
-      return false;
-    settings.source_file = settings.config_file;
-    settings.source_file.replace_extension("cpp");
-  }
-  if (settings.header_file.empty()) {
-    settings.header_file = settings.source_file;
-    settings.header_file.replace_extension("h");
-  }
-  return true;
+  // files loaded at runtime are referenced by absolute path
+  if (settings.relocatable && settings.dev)
+    error("--relocatable cannot be combined with --dev");
+
+  if (settings.cache_dir.empty())
+    if (const auto cache_dir = std::getenv("RES2CPP_CACHE_DIR"))
+      settings.cache_dir = utf8_to_path(cache_dir);
+
+  // in batch mode the paths are deduced per config
+  if (settings.config_files.size() > 1)
+    return (settings.source_file.empty() && settings.header_file.empty() &&
+            settings.depfile.empty());
+  if (!settings.config_files.empty())
+    settings.config_file = settings.config_files.front();
+  return deduce_output_files(settings);
 }
 
 std::string normalize_path(std::string&& path) {
@@ -267,6 +447,25 @@ std::string deduce_id_from_path(bool is_header, const std::string& path) {
   return id;
 }
 
+int parse_transforms(const std::string& string) {
+  auto transforms = 0;
+  auto ss = std::istringstream(replace_all(string, ",", " "));
+  auto name = std::string();
+  while (ss >> name) {
+    if (name == "normalize-eol")
+      transforms |= normalize_eol;
+    else if (name == "strip-comments")
+      transforms |= strip_comments;
+    else if (name == "minify-json")
+      transforms |= minify_json;
+    else if (name == "null-terminate")
+      transforms |= null_terminate;
+    else
+      error("invalid transform '" + name + "'");
+  }
+  return transforms;
+}
+
 std::optional<Definition> parse_definition(const std::string& line) {
   auto it = line.begin();
   auto end = line.end();
@@ -338,6 +537,48 @@ std::optional<Definition> parse_definition(const std::string& line) {
   if (it == end && !definition.is_header)
     return std::nullopt;
 
+  // conditional sections
+  if (definition.is_header) {
+    const auto content = trim({ begin, end });
+    if (content == "else" || content == "endif" ||
+        (content.size() > 2 && content.compare(0, 2, "if") == 0 &&
+         is_space(content[2]))) {
+      definition.is_header = false;
+      if (content == "else") {
+        definition.directive = Directive::else_branch;
+      }
+      else if (content == "endif") {
+        definition.directive = Directive::end_if;
+      }
+      else {
+        auto condition = trim(content.substr(3));
+        definition.directive = Directive::if_defined;
+        if (!condition.empty() && condition.front() == '!') {
+          definition.directive = Directive::if_not_defined;
+          condition = trim(condition.substr(1));
+        }
+        if (!is_valid_identifier(condition) ||
+            condition.find('/') != std::string::npos)
+          error("invalid condition");
+        definition.condition = std::move(condition);
+      }
+      it = end + 1;
+      end = line.end();
+      skip_space();
+      if (it != end && *it != '#')
+        error("invalid definition");
+      return definition;
+    }
+  }
+
+  // transforms follow a '|'
+  const auto definition_end = end;
+  if (skip_until_not_in_string('|')) {
+    definition.transforms = parse_transforms({ it + 1, end });
+    end = it;
+    it = begin;
+  }
+
   // content can be a single sequence or two separated by '='
   // the single or the second sequence can be enclosed in quotes
   if (skip_string()) {
@@ -380,7 +621,7 @@ std::optional<Definition> parse_definition(const std::string& line) {
     error("invalid definition");
 
   if (definition.is_header) {
-    it = end + 1;
+    it = definition_end + 1;
     end = line.end();
     skip_space();
     if (it != end && *it != '#')
@@ -393,9 +634,27 @@ std::optional<Definition> parse_definition(const std::string& line) {
 }
 
 void apply_definition(State& state, const Definition& definition) {
-  if (definition.is_header) {
+  if (definition.directive == Directive::if_defined ||
+      definition.directive == Directive::if_not_defined) {
+    const auto defined = std::count(state.defines.begin(),
+      state.defines.end(), definition.condition) > 0;
+    state.conditions.push_back({
+      defined == (definition.directive == Directive::if_defined), false });
+  }
+  else if (definition.directive == Directive::else_branch) {
+    if (state.conditions.empty() || state.conditions.back().has_else)
+      error("unexpected [else]");
+    state.conditions.back() = { !state.conditions.back().active, true };
+  }
+  else if (definition.directive == Directive::end_if) {
+    if (state.conditions.empty())
+      error("unexpected [endif]");
+    state.conditions.pop_back();
+  }
+  else if (definition.is_header) {
     state.id_prefix = definition.id;
     state.path_prefix = definition.path;
+    state.transforms = definition.transforms;
   }
   else {
     auto id = definition.id;
@@ -407,16 +666,29 @@ void apply_definition(State& state, const Definition& definition) {
       path /= state.path_prefix;
     path /= definition.path;
 
-    state.resources.push_back({ id, path });
+    // excluded resources are only kept to be defined as stubs
+    const auto excluded = std::any_of(state.conditions.begin(),
+      state.conditions.end(), [](const Condition& condition) {
+        return !condition.active;
+      });
+    if (excluded && !state.stubs)
+      return;
+
+    state.resources.push_back({ id, path,
+      state.transforms | definition.transforms,
+      !state.conditions.empty(), excluded });
   }
 }
 
 std::vector<Resource> read_config(std::istream& is, 
-    const std::filesystem::path& base_path) {
+    const std::filesystem::path& base_path,
+    const std::vector<std::string>& defines = { }, bool stubs = false) {
   auto line_no = 0;
   try {
     auto state = State();
     state.base_path = base_path;
+    state.defines = defines;
+    state.stubs = stubs;
 
     auto line = std::string{ };
     while (is.good()) {
@@ -425,6 +697,8 @@ std::vector<Resource> read_config(std::istream& is,
       if (auto definition = parse_definition(line))
         apply_definition(state, *definition);
     }
+    if (!state.conditions.empty())
+      error("missing [endif]");
     return std::move(state.resources);
   }
   catch (const std::exception& ex) {
@@ -465,47 +739,469 @@ bool update_textfile(const std::filesystem::path& filename,
   return true;
 }
 
-size_t hexdump_file(std::ostream& os,
-    const std::filesystem::path& filename,
-    int word_size, bool little_endian, 
-    const std::string& xor_key) {
+std::optional<std::filesystem::file_time_type> get_last_write_time(
+    const std::filesystem::path& filename) {
+  auto error_code = std::error_code{ };
+  const auto time = std::filesystem::last_write_time(filename, error_code);
+  return (error_code ? std::nullopt : std::make_optional(time));
+}
+
+void update_digest(Digest& digest, const char* data, size_t size) {
+  static const auto crc32_table = []() {
+    auto table = std::array<uint32_t, 256>();
+    for (auto i = uint32_t{ }; i < 256; ++i) {
+      auto c = i;
+      for (auto j = 0; j < 8; ++j)
+        c = (c & 1 ? 0xEDB88320 ^ (c >> 1) : c >> 1);
+      table[i] = c;
+    }
+    return table;
+  }();
+
+  auto fnv1a = digest.fnv1a;
+  auto crc32 = digest.crc32;
+  for (auto i = size_t{ }; i < size; ++i) {
+    const auto b = static_cast<unsigned char>(data[i]);
+    fnv1a = (fnv1a ^ b) * 0x100000001B3;
+    crc32 = crc32_table[(crc32 ^ b) & 0xFF] ^ (crc32 >> 8);
+  }
+  digest.fnv1a = fnv1a;
+  digest.crc32 = crc32;
+}
+
+std::string remove_comments(const std::string& data) {
+  auto result = std::string();
+  result.reserve(data.size());
+  for (auto i = size_t{ }; i < data.size(); ) {
+    const auto c = data[i];
+    const auto next = (i + 1 < data.size() ? data[i + 1] : '\0');
+    if (c == '"' || c == '\'') {
+      // copy literal, also stop at line end when it is unterminated
+      auto j = i + 1;
+      while (j < data.size() && data[j] != c && data[j] != '\n')
+        j += (data[j] == '\\' ? 2 : 1);
+      j = std::min(j + 1, data.size());
+      result.append(data, i, j - i);
+      i = j;
+    }
+    else if (c == '/' && next == '/') {
+      i = std::min(data.find('\n', i), data.size());
+    }
+    else if (c == '/' && next == '*') {
+      // keep line breaks, so line numbers are retained
+      const auto end = data.find("*/", i + 2);
+      const auto stop = (end == std::string::npos ? data.size() : end + 2);
+      const auto lines = static_cast<size_t>(std::count(
+        data.begin() + static_cast<std::ptrdiff_t>(i),
+        data.begin() + static_cast<std::ptrdiff_t>(stop), '\n'));
+      result.append(std::max(lines, size_t{ 1 }), (lines ? '\n' : ' '));
+      i = stop;
+    }
+    else {
+      result.push_back(c);
+      ++i;
+    }
+  }
+  return result;
+}
+
+std::string remove_json_whitespace(const std::string& data) {
+  auto result = std::string();
+  result.reserve(data.size());
+  auto in_string = false;
+  for (auto i = size_t{ }; i < data.size(); ++i) {
+    const auto c = data[i];
+    if (in_string) {
+      result.push_back(c);
+      if (c == '\\' && i + 1 < data.size())
+        result.push_back(data[++i]);
+      else if (c == '"')
+        in_string = false;
+    }
+    else if (!is_space(c)) {
+      result.push_back(c);
+      in_string = (c == '"');
+    }
+  }
+  return result;
+}
+
+std::string apply_transforms(std::string data, int transforms) {
+  if (transforms & normalize_eol) {
+    data = replace_all(std::move(data), "\r\n", "\n");
+    std::replace(data.begin(), data.end(), '\r', '\n');
+  }
+  if (transforms & strip_comments)
+    data = remove_comments(data);
+  if (transforms & minify_json)
+    data = remove_json_whitespace(data);
+  return data;
+}
 
-  const auto max_per_line = 100 / (2 * word_size + 3);
+// calls function with a stream of the transformed file content,
+// null-termination is applied by the reader
+template<typename F>
+auto read_resource(const std::filesystem::path& filename, int transforms,
+    F&& function) {
+  if (transforms & ~null_terminate) {
+    auto is = std::istringstream(
+      apply_transforms(read_textfile(filename), transforms));
+    return function(is);
+  }
   auto file = std::ifstream(filename, std::ios::in | std::ios::binary);
   if (!file.good())
     error("reading file '" + path_to_utf8(filename) + "' failed");
-  auto total_size = size_t{ };
-  char input[8];
-  for (auto i = 0; ; ++i) {
-    file.read(input, word_size);
-    const auto read = file.gcount();
-    if (read != word_size)
-      std::memset(input + read, 0x00, word_size - read);
-    if (read) {
-      if (i > 0) {
-        os.put(',');
-        if (i % max_per_line == 0)
-          os.put('\n');
-      }
+  return function(file);
+}
+
+Digest digest_file(const std::filesystem::path& filename, int transforms) {
+  return read_resource(filename, transforms, [](std::istream& file) {
+    auto digest = Digest{ };
+    char buffer[4096];
+    do {
+      file.read(buffer, sizeof(buffer));
+      update_digest(digest, buffer, static_cast<size_t>(file.gcount()));
+    } while (file.good());
+    return digest;
+  });
+}
+
+std::string to_hex(uint64_t value, int digits) {
+  auto string = std::string("0x");
+  for (auto i = digits - 1; i >= 0; --i)
+    string.push_back("0123456789ABCDEF"[(value >> (4 * i)) & 0xF]);
+  return string;
+}
+
+// applies the key in blocks of its length, which allows vectorization
+void xor_cipher(char* data, size_t size, size_t offset,
+    std::string_view key) {
+  auto k = offset % key.size();
+  for (; k != 0 && k < key.size() && size != 0; ++k, --size)
+    *data++ ^= key[k];
+  for (; size >= key.size(); size -= key.size(), data += key.size())
+    for (auto i = size_t{ }; i < key.size(); ++i)
+      data[i] ^= key[i];
+  for (auto i = size_t{ }; i < size; ++i)
+    data[i] ^= key[i];
+}
+
+size_t hexdump_file(std::ostream& os,
+    const std::filesystem::path& filename, int transforms,
+    int word_size, bool little_endian, 
+    const std::string& xor_key, Digest& digest) {
+  return read_resource(filename, transforms, [&](std::istream& file) {
+    const auto max_per_line = size_t(100 / (2 * word_size + 3));
+    auto total_size = size_t{ };
+    auto input = std::vector<char>(64 * 1024);
+    auto output = std::string();
+    for (auto i = size_t{ }; ; ) {
+      file.read(input.data(), static_cast<std::streamsize>(input.size()));
+      const auto read = static_cast<size_t>(file.gcount());
+      update_digest(digest, input.data(), read);
+
+      // terminating null is not included in size
+      auto size = read;
+      if (read != input.size() && (transforms & null_terminate))
+        input[size++] = 0x00;
+
+      // last word is padded with zeros
+      const auto padded = (size + word_size - 1) / word_size * word_size;
+      std::memset(input.data() + size, 0x00, padded - size);
 
       if (!xor_key.empty())
-        for (auto j = 0; j < word_size; ++j)
-          input[j] ^= xor_key[(total_size + j) % xor_key.size()];
-
-      os.write("0x", 2);
-      for (auto j = 0; j < word_size; ++j) {
-        const auto hex = "0123456789ABCDEF";
-        const auto b = static_cast<unsigned char>(
-          input[little_endian ? word_size - j - 1 : j]);
-        os.put(hex[b / 16]);
-        os.put(hex[b % 16]);
+        xor_cipher(input.data(), padded, total_size, xor_key);
+
+      output.clear();
+      for (auto word = input.data(); word != input.data() + padded;
+           word += word_size, ++i) {
+        if (i > 0) {
+          output.push_back(',');
+          if (i % max_per_line == 0)
+            output.push_back('\n');
+        }
+        output.append("0x");
+        for (auto j = 0; j < word_size; ++j) {
+          const auto hex = "0123456789ABCDEF";
+          const auto b = static_cast<unsigned char>(
+            word[little_endian ? word_size - j - 1 : j]);
+          output.push_back(hex[b / 16]);
+          output.push_back(hex[b % 16]);
+        }
       }
+      os.write(output.data(), static_cast<std::streamsize>(output.size()));
       total_size += read;
+      if (read != input.size()) {
+        // arrays must not be empty
+        if (i == 0)
+          os << "0x" << std::string(2 * static_cast<size_t>(word_size), '0');
+        break;
+      }
+    }
+    return total_size;
+  });
+}
+
+CacheKey get_cache_key(const Resource& resource) {
+  return { std::filesystem::absolute(resource.path).lexically_normal(),
+           resource.transforms };
+}
+
+// entries are identified by the content's digest and the encoding settings
+std::filesystem::path get_cache_entry_filename(const Settings& settings,
+    const Resource& resource) {
+  const auto content = digest_file(resource.path, 0);
+  const auto encoding = "res2cpp1 " +
+    std::to_string(settings.little_endian.has_value() ? 8 : 1) +
+    (settings.little_endian.value_or(true) ? " LE " : " BE ") +
+    std::to_string(resource.transforms) + " " + settings.xor_key;
+  auto encoding_digest = Digest{ };
+  update_digest(encoding_digest, encoding.data(), encoding.size());
+  const auto key = to_hex(content.fnv1a, 16).substr(2) +
+    to_hex(~content.crc32, 8).substr(2) +
+    to_hex(encoding_digest.fnv1a, 16).substr(2);
+  return settings.cache_dir / key.substr(0, 2) / key;
+}
+
+// writes the hexdump of an entry to the output stream
+bool read_cache_entry(const std::filesystem::path& filename,
+    CachedFile& file, std::ostream& os) {
+  auto is = std::ifstream(filename, std::ios::in | std::ios::binary);
+  auto digest = Digest{ };
+  auto size = size_t{ };
+  if (!(is >> size >> std::hex >> digest.fnv1a >> digest.crc32) ||
+      is.get() != '\n')
+    return false;
+  os << is.rdbuf();
+  if (!os.good())
+    error("reading file '" + path_to_utf8(filename) + "' failed");
+  file.size = size;
+  file.digest = digest;
+
+  // update time for least recently used eviction
+  auto error_code = std::error_code{ };
+  std::filesystem::last_write_time(filename,
+    std::filesystem::file_time_type::clock::now(), error_code);
+  return true;
+}
+
+std::filesystem::path get_temporary_filename(
+    const std::filesystem::path& filename) {
+  const auto unique = std::to_string(std::random_device{ }()) + "_" +
+    std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+  auto temporary = filename;
+  temporary += ".tmp" + unique;
+  return temporary;
+}
+
+// forwards the output to two stream buffers
+class TeeBuffer : public std::streambuf {
+public:
+  TeeBuffer(std::streambuf* a, std::streambuf* b)
+    : m_a(a), m_b(b) {
+  }
+
+protected:
+  int_type overflow(int_type c) override {
+    if (traits_type::eq_int_type(c, traits_type::eof()))
+      return traits_type::not_eof(c);
+    const auto ch = traits_type::to_char_type(c);
+    if (traits_type::eq_int_type(m_a->sputc(ch), traits_type::eof()) ||
+        traits_type::eq_int_type(m_b->sputc(ch), traits_type::eof()))
+      return traits_type::eof();
+    return c;
+  }
+
+  std::streamsize xsputn(const char* s, std::streamsize n) override {
+    const auto a = m_a->sputn(s, n);
+    const auto b = m_b->sputn(s, n);
+    return std::min(a, b);
+  }
+
+private:
+  std::streambuf* m_a;
+  std::streambuf* m_b;
+};
+
+// writes the hexdump to an entry and the output stream, the header is
+// fixed-size, so it can be written when the digest is known
+void write_cache_entry(const std::filesystem::path& filename,
+    CachedFile& file, std::ostream& os,
+    const std::function<void(std::ostream&)>& write_hexdump) {
+  const auto write_entry_header = [&](std::ostream& entry) {
+    const auto digest = file.digest.value_or(Digest{ });
+    auto size = std::to_string(file.size);
+    size.insert(0, 20 - std::min(size.size(), size_t{ 20 }), '0');
+    entry << size << " " << to_hex(digest.fnv1a, 16).substr(2) << " "
+      << to_hex(digest.crc32, 8).substr(2) << "\n";
+  };
+
+  // write to temporary file and rename, so others never see partial entries
+  const auto temporary = get_temporary_filename(filename);
+  auto error_code = std::error_code{ };
+  try {
+    auto entry = open_file_for_writing(temporary);
+    write_entry_header(entry);
+    auto tee_buffer = TeeBuffer(entry.rdbuf(), os.rdbuf());
+    auto tee = std::ostream(&tee_buffer);
+    write_hexdump(tee);
+    entry.seekp(0);
+    write_entry_header(entry);
+    if (!tee.good() || !entry.good())
+      error("writing file '" + path_to_utf8(temporary) + "' failed");
+  }
+  catch (...) {
+    std::filesystem::remove(temporary, error_code);
+    throw;
+  }
+  std::filesystem::rename(temporary, filename, error_code);
+  if (error_code)
+    std::filesystem::remove(temporary, error_code);
+}
+
+// evicts least recently used entries, skipped while another process is
+// evicting, which is signaled by the existence of a lock directory
+void trim_cache(const Settings& settings) {
+  auto error_code = std::error_code{ };
+  const auto lock = settings.cache_dir / "lock";
+  if (!std::filesystem::create_directory(lock, error_code)) {
+    // remove lock of crashed process
+    const auto lock_time = get_last_write_time(lock);
+    if (lock_time && *lock_time < std::filesystem::file_time_type::clock::now() -
+          std::chrono::minutes(10))
+      std::filesystem::remove(lock, error_code);
+    return;
+  }
+
+  struct Entry {
+    std::filesystem::file_time_type time;
+    uintmax_t size;
+    std::filesystem::path filename;
+  };
+  auto entries = std::vector<Entry>();
+  auto total_size = uintmax_t{ };
+  for (auto it = std::filesystem::recursive_directory_iterator(
+          settings.cache_dir, error_code);
+       !error_code && it != std::filesystem::recursive_directory_iterator();
+       it.increment(error_code)) {
+    if (!it->is_regular_file(error_code))
+      continue;
+    const auto time = it->last_write_time(error_code);
+    const auto size = it->file_size(error_code);
+    if (error_code)
+      continue;
+    entries.push_back({ time, size, it->path() });
+    total_size += size;
+  }
+
+  std::sort(entries.begin(), entries.end(),
+    [](const Entry& a, const Entry& b) { return a.time < b.time; });
+  const auto max_size = settings.cache_size * 1024 * 1024;
+  for (auto it = entries.begin(); it != entries.end() &&
+       total_size > max_size; ++it)
+    if (std::filesystem::remove(it->filename, error_code))
+      total_size -= it->size;
+
+  std::filesystem::remove(lock, error_code);
+}
+
+// streams the hexdump from the cache directory or the file
+size_t stream_hexdump(std::ostream& os, const Settings& settings,
+    const Resource& resource, CachedFile& file) {
+  const auto hexdump = [&](std::ostream& os) {
+    auto digest = Digest{ };
+    file.size = hexdump_file(os, resource.path, resource.transforms,
+      (settings.little_endian.has_value() ? 8 : 1),
+      settings.little_endian.value_or(true),
+      settings.xor_key, digest);
+    file.digest = digest;
+  };
+
+  if (settings.cache_dir.empty()) {
+    hexdump(os);
+  }
+  else {
+    const auto filename = get_cache_entry_filename(settings, resource);
+    if (!read_cache_entry(filename, file, os)) {
+      write_cache_entry(filename, file, os, hexdump);
+      file.stored = true;
     }
-    if (read != word_size)
-      break;
   }
-  return total_size;
+  return file.size;
+}
+
+size_t write_hexdump(std::ostream& os, const Settings& settings,
+    const Resource& resource, CachedFile& file) {
+  // keep hexdump of files, which are shared with other configs
+  if (!file.hexdump && file.uses > 1) {
+    auto ss = std::ostringstream();
+    stream_hexdump(ss, settings, resource, file);
+    file.hexdump = ss.str();
+  }
+  if (!file.hexdump)
+    return stream_hexdump(os, settings, resource, file);
+  os << *file.hexdump;
+  return file.size;
+}
+
+// encrypted and transformed resources are still embedded in dev mode
+bool is_loaded_at_runtime(const Settings& settings, const Resource& resource) {
+  return (settings.dev && settings.xor_key.empty() && !resource.transforms);
+}
+
+std::filesystem::path get_relative_path(const std::filesystem::path& path,
+    const std::filesystem::path& base) {
+  const auto absolute_base = (base.empty() ? std::filesystem::current_path() :
+    std::filesystem::absolute(base));
+  return std::filesystem::absolute(path).lexically_normal().lexically_relative(
+    absolute_base.lexically_normal());
+}
+
+// relocatable sources include the header relative to their directory
+std::string get_header_include(const Settings& settings) {
+  if (!settings.relocatable)
+    return path_to_utf8(settings.header_file);
+  const auto include = get_relative_path(settings.header_file,
+    settings.source_file.parent_path());
+  if (include.empty())
+    error("header is not reachable from source directory");
+  return path_to_utf8(include);
+}
+
+std::string get_generated_comment(const Settings& settings,
+    const std::vector<Resource>& resources, bool is_header) {
+  auto comment = std::string("// automatically generated by res2cpp");
+  // ensure that all settings affect header, which invalidates output
+  if (settings.portable)
+    comment += " [LE/BE]";
+  else if (settings.little_endian.has_value())
+    comment += (settings.little_endian.value() ? " [LE]" : " [BE]");
+  // settings which only affect the source
+  if (!is_header && settings.dev)
+    comment += " [DEV]";
+  if (!is_header && settings.relocatable)
+    comment += " [REL]";
+  // the header can be identical for all variants, so the source
+  // identifies the selected conditional resources
+  const auto base_path = settings.config_file.parent_path();
+  auto variant = Digest{ };
+  auto conditional = false;
+  for (const auto& resource : resources)
+    if (resource.conditional) {
+      // path relative to config, so it does not depend on the location
+      const auto path = get_relative_path(resource.path, base_path);
+      const auto string = resource.id + (resource.stub ? "" : "=" +
+        path_to_utf8(path) + "|" + std::to_string(resource.transforms)) + "\n";
+      update_digest(variant, string.data(), string.size());
+      conditional = true;
+    }
+  if (!is_header && conditional)
+    comment += " [VARIANT " + to_hex(variant.fnv1a, 16) + "]";
+  return comment;
+}
+
+std::string escape_string_literal(const std::string& string) {
+  return replace_all(replace_all(string, "\\", "\\\\"), "\"", "\\\"");
 }
 
 template<typename F>
@@ -523,7 +1219,8 @@ void for_each_identifier(const std::string& string, F&& function) {
 }
 
 void generate_output(std::ostream& os, const Settings& settings,
-    const std::vector<Resource>& resources, bool is_header) {
+    const std::vector<Resource>& resources, bool is_header,
+    Cache& cache, const std::vector<std::string>& group_headers = { }) {
 
   auto qualified_resource_type =
     (!settings.resource_type.empty() ? settings.resource_type :
@@ -531,7 +1228,7 @@ void generate_output(std::ostream& os, const Settings& settings,
   auto current_namespace = std::vector<std::string_view>();
   auto resource_type_parts = std::vector<std::string_view>();
   auto resource_type = std::string_view();
-  auto resource_by_path = std::map<std::filesystem::path, std::string_view>();
+  auto resource_by_file = std::map<CacheKey, std::string_view>();
 
   // depending on current namespace make resource_type point
   // to fully qualified type name or last part only
@@ -566,20 +1263,49 @@ void generate_output(std::ostream& os, const Settings& settings,
       close_namespace(current_namespace.back());
     return true;
   };
-  const auto write_header = [&](std::string_view name) {
+  const auto write_header = [&](std::string_view name,
+      const Resource& resource) {
     write_indent();
     os << "extern const " << resource_type << " " << name << ";\n";
+    // digests of conditional resources would differ between variants
+    if ((!settings.digest_fnv1a && !settings.digest_crc32) ||
+        (settings.stubs && resource.conditional))
+      return;
+    const auto digest = *cache.at(get_cache_key(resource)).digest;
+    if (settings.digest_fnv1a) {
+      write_indent();
+      os << "constexpr uint64_t " << name << "_fnv1a = "
+        << to_hex(digest.fnv1a, 16) << "ULL;\n";
+    }
+    if (settings.digest_crc32) {
+      write_indent();
+      os << "constexpr uint32_t " << name << "_crc32 = "
+        << to_hex(~digest.crc32, 8) << ";\n";
+    }
   };
   const auto write_output = [&](std::string_view name,
-      const std::filesystem::path& path) {
+      const Resource& resource) {
     write_indent();
     os << "const "
       << (settings.little_endian.has_value() ? "uint64_t " : "uint8_t ")
       << name << "_data_[] {\n";
-    const auto data_size = hexdump_file(os, path,
-      (settings.little_endian.has_value() ? 8 : 1),
-      settings.little_endian.value_or(true),
-      settings.xor_key);
+    auto data_size = size_t{ };
+    auto& file = cache[get_cache_key(resource)];
+    if (settings.portable) {
+      // the big endian hexdump is streamed once and not kept
+      auto big_endian_settings = settings;
+      big_endian_settings.little_endian.emplace(false);
+      auto big_endian_file = CachedFile{ };
+      os << "#if RES2CPP_BIG_ENDIAN\n";
+      stream_hexdump(os, big_endian_settings, resource, big_endian_file);
+      file.stored |= big_endian_file.stored;
+      os << "\n#else\n";
+      data_size = write_hexdump(os, settings, resource, file);
+      os << "\n#endif";
+    }
+    else {
+      data_size = write_hexdump(os, settings, resource, file);
+    }
     os << "\n";
     write_indent();
     os << "};\n";
@@ -588,6 +1314,22 @@ void generate_output(std::ostream& os, const Settings& settings,
       << "{ reinterpret_cast<const " + settings.data_type + "*>("
       << name << "_data_), " << data_size << " };\n";
   };
+  const auto write_loaded = [&](std::string_view name,
+      const Resource& resource) {
+    write_indent();
+    os << "const auto " << name << "_file_ = res2cpp_load_file(\""
+      << escape_string_literal(path_to_utf8(
+          std::filesystem::absolute(resource.path).lexically_normal()))
+      << "\");\n";
+    write_indent();
+    os << "const " << resource_type << " " << name
+      << "{ reinterpret_cast<const " + settings.data_type + "*>("
+      << name << "_file_.data), " << name << "_file_.size };\n";
+  };
+  const auto write_stub = [&](std::string_view name) {
+    write_indent();
+    os << "const " << resource_type << " " << name << "{ nullptr, 0 };\n";
+  };
   const auto write_duplicate = [&](std::string_view name, std::string_view first) {
     write_indent();
     os << "const " << resource_type << " " << name << " = " << first << ";\n";
@@ -596,15 +1338,11 @@ void generate_output(std::ostream& os, const Settings& settings,
   if (is_header)
     os << "#pragma once\n";
   os << "\n";
-  os << "// automatically generated by res2cpp";
-  // ensure that all settings affect header, which invalidates output
-  if (settings.little_endian.has_value())
-    os << (settings.little_endian.value() ? " [LE]" : " [BE]");
-  os << "\n";
+  os << get_generated_comment(settings, resources, is_header) << "\n";
   os << "// https://github.com/houmain/res2cpp\n\n";
 
   if (!is_header) {
-    os << "#include \"" << path_to_utf8(settings.header_file) << "\"\n";
+    os << "#include \"" << get_header_include(settings) << "\"\n";
     os << "#include <cstdint>\n";
   }
   else if (settings.includes.size() == 1 &&
@@ -618,8 +1356,111 @@ void generate_output(std::ostream& os, const Settings& settings,
     for (const auto& include : settings.includes)
       os << "#include " << include << "\n";
   }
+  if (is_header && (settings.digest_fnv1a || settings.digest_crc32))
+    os << "#include <cstdint>\n";
+  if (is_header && !settings.xor_key.empty())
+    os << "#include <cstring>\n"
+          "#include <string_view>\n";
+  for (const auto& group_header : group_headers)
+    os << "#include \"" << group_header << "\"\n";
   os << "\n";
 
+  // declare helper for loading files at runtime
+  if (!is_header && std::any_of(resources.begin(), resources.end(),
+        [&](const Resource& resource) {
+          return (!resource.stub && is_loaded_at_runtime(settings, resource));
+        }))
+    os <<
+      "#include <cstdio>\n"
+      "#include <utility>\n"
+      "#include <vector>\n"
+      "#if defined(_WIN32)\n"
+      "# if !defined(WIN32_LEAN_AND_MEAN)\n"
+      "#  define WIN32_LEAN_AND_MEAN\n"
+      "# endif\n"
+      "# include <windows.h>\n"
+      "#endif\n"
+      "\n"
+      "#ifndef RES2CPP_LOAD_FILE\n"
+      "#define RES2CPP_LOAD_FILE\n"
+      "namespace {\n"
+      "  struct res2cpp_loaded_file {\n"
+      "    const void* data;\n"
+      "    size_t size;\n"
+      "  };\n"
+      "\n"
+      "  // the content is copied, so later modifications of the file do not\n"
+      "  // affect the program, it is kept until the program exits\n"
+      "  res2cpp_loaded_file res2cpp_load_file(const char* filename) {\n"
+      "    static const unsigned char empty[1] { };\n"
+      "#if defined(_WIN32)\n"
+      "    wchar_t path[32768];\n"
+      "    if (!::MultiByteToWideChar(CP_UTF8, 0, filename, -1, path, 32768))\n"
+      "      path[0] = L'\\0';\n"
+      "    auto file = static_cast<std::FILE*>(nullptr);\n"
+      "    if (::_wfopen_s(&file, path, L\"rb\") != 0)\n"
+      "      file = nullptr;\n"
+      "#else\n"
+      "    const auto file = std::fopen(filename, \"rb\");\n"
+      "#endif\n"
+      "    if (!file) {\n"
+      "      std::fprintf(stderr, \"res2cpp: loading '%s' failed\\n\", filename);\n"
+      "      return { empty, 0 };\n"
+      "    }\n"
+      "    auto data = std::vector<unsigned char>();\n"
+      "    unsigned char buffer[4096];\n"
+      "    for (auto size = size_t{ }; (size = std::fread(buffer, 1,\n"
+      "        sizeof(buffer), file)) > 0; )\n"
+      "      data.insert(data.end(), buffer, buffer + size);\n"
+      "    std::fclose(file);\n"
+      "    if (data.empty())\n"
+      "      return { empty, 0 };\n"
+      "    const auto kept = new std::vector<unsigned char>(std::move(data));\n"
+      "    return { kept->data(), kept->size() };\n"
+      "  }\n"
+      "} // namespace\n"
+      "#endif\n\n";
+
+  // select byte order of words at compile-time
+  if (!is_header && settings.portable)
+    os <<
+      "#if !defined(RES2CPP_BIG_ENDIAN)\n"
+      "# if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && \\\n"
+      "     __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__\n"
+      "#  define RES2CPP_BIG_ENDIAN 1\n"
+      "# else\n"
+      "#  define RES2CPP_BIG_ENDIAN 0\n"
+      "# endif\n"
+      "#endif\n\n";
+
+  // declare helper for decoding data encrypted with --xor
+  if (is_header && !settings.xor_key.empty())
+    os <<
+      "#ifndef RES2CPP_XOR_DECODE\n"
+      "#define RES2CPP_XOR_DECODE\n"
+      "namespace res2cpp {\n"
+      "  // decodes size bytes starting at offset to output\n"
+      "  inline void xor_decode(const void* data, size_t offset, size_t size,\n"
+      "      void* output, std::string_view key) {\n"
+      "    auto in = static_cast<const unsigned char*>(data) + offset;\n"
+      "    auto out = static_cast<unsigned char*>(output);\n"
+      "    const auto n = key.size();\n"
+      "    const auto k = reinterpret_cast<const unsigned char*>(key.data());\n"
+      "    if (n == 0) {\n"
+      "      std::memmove(out, in, size);\n"
+      "      return;\n"
+      "    }\n"
+      "    for (auto i = offset % n; i != 0 && i < n && size != 0; ++i, --size)\n"
+      "      *out++ = *in++ ^ k[i];\n"
+      "    for (; size >= n; size -= n, in += n, out += n)\n"
+      "      for (size_t i = 0; i < n; ++i)\n"
+      "        out[i] = in[i] ^ k[i];\n"
+      "    for (size_t i = 0; i < size; ++i)\n"
+      "      out[i] = in[i] ^ k[i];\n"
+      "  }\n"
+      "} // namespace res2cpp\n"
+      "#endif\n\n";
+
   // declare type alias
   const auto resource_alias_id =
     replace_all(settings.resource_alias, "::", "/");
@@ -646,22 +1487,30 @@ void generate_output(std::ostream& os, const Settings& settings,
     [&](std::string_view ident, bool last) {
       resource_type_parts.push_back(ident);
     });
+  qualify_resource_type();
 
-  for (const auto& [id, path] : resources) {
+  for (const auto& resource : resources) {
+    const auto file = CacheKey{ resource.path, resource.transforms };
     auto level = size_t{ };
-    for_each_identifier(id, [&](std::string_view ident, bool last) {
+    for_each_identifier(resource.id, [&](std::string_view ident, bool last) {
       if (last) {
         close_namespaces(level);
         if (is_header) {
-          write_header(ident);
+          write_header(ident, resource);
+        }
+        else if (resource.stub) {
+          write_stub(ident);
         }
-        else if (const auto it = resource_by_path.find(path); 
-                 it != resource_by_path.end()) {
+        else if (const auto it = resource_by_file.find(file); 
+                 it != resource_by_file.end()) {
           write_duplicate(ident, replace_all(std::string(it->second), "/", "::"));
         }
         else {
-          write_output(ident, path);
-          resource_by_path[path] = id;
+          if (is_loaded_at_runtime(settings, resource))
+            write_loaded(ident, resource);
+          else
+            write_output(ident, resource);
+          resource_by_file[file] = resource.id;
         }
       }
       else if (level >= current_namespace.size() ||
@@ -676,65 +1525,602 @@ void generate_output(std::ostream& os, const Settings& settings,
   close_namespaces(0);
 }
 
-std::optional<std::filesystem::file_time_type> get_last_write_time(
-    const std::filesystem::path& filename) {
-  auto error_code = std::error_code{ };
-  const auto time = std::filesystem::last_write_time(filename, error_code);
-  return (error_code ? std::nullopt : std::make_optional(time));
+std::string get_group(const std::string& id) {
+  const auto slash = id.find('/');
+  return (slash == std::string::npos ? "" : id.substr(0, slash));
 }
 
-bool input_files_modified(const Settings& settings,
+std::filesystem::path get_group_header_file(
+    const std::filesystem::path& header_file, const std::string& group) {
+  auto filename = header_file;
+  filename.replace_filename(utf8_to_path(path_to_utf8(header_file.stem()) +
+    "_" + group + path_to_utf8(header_file.extension())));
+  return filename;
+}
+
+// resources are sorted by id, so each group is a contiguous range
+template<typename F>
+void for_each_group(const std::vector<Resource>& resources, F&& function) {
+  for (auto it = resources.begin(); it != resources.end(); ) {
+    const auto group = get_group(it->id);
+    const auto end = std::find_if(it, resources.end(),
+      [&](const Resource& resource) { return get_group(resource.id) != group; });
+    function(group, it, end);
+    it = end;
+  }
+}
+
+std::vector<std::filesystem::path> get_header_files(const Settings& settings,
+    const std::vector<Resource>& resources) {
+  auto header_files = std::vector<std::filesystem::path>();
+  if (settings.group_headers)
+    for_each_group(resources, [&](const std::string& group, auto, auto) {
+      if (!group.empty())
+        header_files.push_back(
+          get_group_header_file(settings.header_file, group));
+    });
+  header_files.push_back(settings.header_file);
+  return header_files;
+}
+
+bool is_generated_file(const std::filesystem::path& filename) {
+  auto file = std::ifstream(filename);
+  auto line = std::string();
+  return (std::getline(file, line) && std::getline(file, line) &&
+          std::getline(file, line) &&
+          line.rfind("// automatically generated by res2cpp", 0) == 0);
+}
+
+// removes the group headers included by the previous main header,
+// which are no longer generated
+void remove_group_headers(const Settings& settings,
+    const std::vector<std::string>& group_headers) {
+  const auto prefix = path_to_utf8(settings.header_file.stem()) + "_";
+  const auto include = std::string("#include \"");
+  auto file = std::ifstream(settings.header_file);
+  auto line = std::string();
+  auto removed = std::vector<std::filesystem::path>();
+  while (std::getline(file, line)) {
+    if (line.rfind(include, 0) != 0 || line.back() != '"')
+      continue;
+    const auto name = line.substr(include.size(),
+      line.size() - include.size() - 1);
+    if (name.rfind(prefix, 0) != 0 ||
+        std::count(group_headers.begin(), group_headers.end(), name) ||
+        std::count(settings.includes.begin(), settings.includes.end(), name))
+      continue;
+    const auto filename = settings.header_file.parent_path() /
+      utf8_to_path(name);
+    if (is_generated_file(filename))
+      removed.push_back(filename);
+  }
+  file.close();
+  for (const auto& filename : removed) {
+    auto error_code = std::error_code{ };
+    std::filesystem::remove(filename, error_code);
+  }
+}
+
+void update_headers(const Settings& settings,
+    const std::vector<Resource>& resources, Cache& cache) {
+  auto ungrouped = std::vector<Resource>();
+  auto group_headers = std::vector<std::string>();
+  if (!settings.group_headers) {
+    ungrouped = resources;
+  }
+  else {
+    for_each_group(resources, [&](const std::string& group,
+        auto begin, auto end) {
+      if (group.empty()) {
+        ungrouped.insert(ungrouped.end(), begin, end);
+      }
+      else {
+        const auto filename = get_group_header_file(settings.header_file, group);
+        auto ss = std::ostringstream();
+        generate_output(ss, settings, { begin, end }, true, cache);
+        update_textfile(filename, ss.str());
+        group_headers.push_back(path_to_utf8(filename.filename()));
+      }
+    });
+  }
+
+  remove_group_headers(settings, group_headers);
+
+  // the main header includes the group headers
+  auto ss = std::ostringstream();
+  generate_output(ss, settings, ungrouped, true, cache, group_headers);
+  update_textfile(settings.header_file, ss.str());
+}
+
+std::filesystem::path get_shard_source_file(
+    const std::filesystem::path& source_file, int index) {
+  auto filename = source_file;
+  filename.replace_filename(utf8_to_path(path_to_utf8(source_file.stem()) +
+    "_" + std::to_string(index) + path_to_utf8(source_file.extension())));
+  return filename;
+}
+
+std::vector<Shard> get_shards(const Settings& settings,
     const std::vector<Resource>& resources) {
+  if (settings.shards <= 1)
+    return { { settings.source_file, resources } };
+
+  auto shards = std::vector<Shard>(static_cast<size_t>(settings.shards));
+  for (auto i = 0; i < settings.shards; ++i)
+    shards[static_cast<size_t>(i)].source_file =
+      get_shard_source_file(settings.source_file, i);
+
+  // assign by id of first resource using a file, since duplicates
+  // refer to it and need to be in the same shard
+  auto first_ids = std::map<CacheKey, const std::string*>();
+  for (const auto& resource : resources) {
+    const auto& id = (resource.stub ? resource.id : *first_ids.emplace(
+      CacheKey{ resource.path, resource.transforms },
+      &resource.id).first->second);
+    auto digest = Digest{ };
+    update_digest(digest, id.data(), id.size());
+    shards[digest.fnv1a % shards.size()].resources.push_back(resource);
+  }
+  return shards;
+}
+
+bool input_files_modified(const Settings& settings,
+    const std::vector<std::filesystem::path>& header_files,
+    const Shard& shard) {
   const auto config_time = get_last_write_time(settings.config_file);
-  const auto header_time = get_last_write_time(settings.header_file);
-  const auto source_time = get_last_write_time(settings.source_file);
+  auto header_time = std::optional<std::filesystem::file_time_type>();
+  for (const auto& header_file : header_files) {
+    const auto time = get_last_write_time(header_file);
+    if (!time)
+      return true;
+    header_time = std::max(header_time, time);
+  }
+  const auto source_time = get_last_write_time(shard.source_file);
   if (!header_time || config_time > header_time ||
       !source_time || config_time > source_time ||
       header_time > source_time)
     return true;
 
-  for (const auto& [id, path] : resources) {
-    const auto resource_time = get_last_write_time(path);
+  // check settings which only affect the source
+  auto file = std::ifstream(shard.source_file);
+  auto line = std::string();
+  if (!std::getline(file, line) || !std::getline(file, line) ||
+      line != get_generated_comment(settings, shard.resources, false))
+    return true;
+
+  for (const auto& resource : shard.resources) {
+    // content of files loaded at runtime does not affect source
+    if (resource.stub || is_loaded_at_runtime(settings, resource))
+      continue;
+
+    const auto resource_time = get_last_write_time(resource.path);
     if (!resource_time || resource_time > source_time)
       return true;
   }
   return false;
 }
 
-int main(int argc, const char* argv[]) try {
-  auto settings = Settings();
-  if (!interpret_commandline(settings, argc, argv)) {
-    print_help_message();
-    return 1;
+std::string escape_depfile_path(const std::filesystem::path& path) {
+  return replace_all(replace_all(replace_all(path_to_utf8(path),
+    "$", "$$"), "#", "\\#"), " ", "\\ ");
+}
+
+void write_depfile(const Settings& settings,
+    const std::vector<Resource>& resources) {
+  auto dependencies = std::vector<std::filesystem::path>();
+  if (!settings.config_file.empty())
+    dependencies.push_back(settings.config_file);
+  for (const auto& resource : resources)
+    if (!resource.stub)
+      dependencies.push_back(resource.path);
+  for (auto& dependency : dependencies)
+    dependency = std::filesystem::absolute(dependency).lexically_normal();
+  std::sort(dependencies.begin(), dependencies.end());
+  dependencies.erase(std::unique(dependencies.begin(), dependencies.end()),
+    dependencies.end());
+
+  // always written, so it is newer than its dependencies
+  auto ss = std::ostringstream();
+  ss << escape_depfile_path(settings.depfile) << ":";
+  for (const auto& dependency : dependencies)
+    ss << " \\\n  " << escape_depfile_path(dependency);
+  ss << "\n";
+  write_textfile(settings.depfile, ss.str());
+}
+
+struct SymbolFile {
+  std::filesystem::path filename;
+  std::string content;
+};
+
+// linker maps of GNU ld list the sections removed by --gc-sections
+std::string remove_discarded_sections(std::string content) {
+  const auto begin = content.find("Discarded input sections");
+  if (begin != std::string::npos)
+    content.erase(begin, content.find("Memory Configuration", begin) - begin);
+  return content;
+}
+
+std::vector<SymbolFile> read_symbol_files(const Settings& settings) {
+  auto symbol_files = std::vector<SymbolFile>();
+  for (const auto& filename : settings.symbol_files)
+    symbol_files.push_back({ filename,
+      remove_discarded_sections(read_textfile(filename)) });
+  return symbol_files;
+}
+
+// objects of the generated sources define the resources, which does
+// not count as reference (e.g. config.o, config.cpp.o, config_0.obj)
+bool is_generated_object(const Settings& settings,
+    const std::filesystem::path& filename) {
+  auto name = filename;
+  if (name.extension() != ".o" && name.extension() != ".obj")
+    return false;
+  name.replace_extension();
+  if (name.extension() == settings.source_file.extension())
+    name.replace_extension();
+  const auto stem = name.filename();
+  if (stem == settings.source_file.stem())
+    return true;
+  for (auto i = 0; settings.shards > 1 && i < settings.shards; ++i)
+    if (stem == get_shard_source_file(settings.source_file, i).stem())
+      return true;
+  return false;
+}
+
+bool is_symbol_char(char c) {
+  return (is_alnum(c) || c == '_' || c == '$' || c == ':');
+}
+
+// finds a symbol, which is not part of a longer one, an additional
+// leading underscore is accepted (Mach-O)
+bool contains_symbol(const std::string& content, const std::string& symbol,
+    bool match_prefix) {
+  for (auto pos = content.find(symbol); pos != std::string::npos;
+       pos = content.find(symbol, pos + 1)) {
+    auto begin = pos;
+    if (begin > 0 && content[begin - 1] == '_')
+      --begin;
+    const auto end = pos + symbol.size();
+    if ((begin == 0 || !is_symbol_char(content[begin - 1])) &&
+        (match_prefix || end == content.size() ||
+         !is_symbol_char(content[end])))
+      return true;
+  }
+  return false;
+}
+
+// a resource is referenced when its Itanium or MSVC mangled name
+// or its demangled name occurs
+bool is_resource_referenced(const Resource& resource,
+    const std::vector<SymbolFile>& symbol_files, const Settings& settings) {
+  auto idents = std::vector<std::string>();
+  for_each_identifier(resource.id, [&](std::string_view ident, bool) {
+    idents.emplace_back(ident);
+  });
+  auto itanium = idents.back();
+  auto msvc = "?" + idents.back() + "@";
+  if (idents.size() > 1) {
+    itanium = "_ZN";
+    for (const auto& ident : idents)
+      itanium += std::to_string(ident.size()) + ident;
+    itanium += "E";
+    for (auto it = std::next(idents.rbegin()); it != idents.rend(); ++it)
+      msvc += *it + "@";
+  }
+  msvc += "@3";
+  const auto demangled = replace_all(resource.id, "/", "::");
+
+  for (const auto& symbol_file : symbol_files)
+    if (!is_generated_object(settings, symbol_file.filename) &&
+        (contains_symbol(symbol_file.content, itanium, false) ||
+         contains_symbol(symbol_file.content, msvc, true) ||
+         contains_symbol(symbol_file.content, demangled, false)))
+      return true;
+  return false;
+}
+
+size_t get_resource_size(const Resource& resource) {
+  return read_resource(resource.path, resource.transforms,
+    [](std::istream& file) {
+      auto size = size_t{ };
+      char buffer[4096];
+      do {
+        file.read(buffer, sizeof(buffer));
+        size += static_cast<size_t>(file.gcount());
+      } while (file.good());
+      return size;
+    }) + ((resource.transforms & null_terminate) ? 1 : 0);
+}
+
+// lists the resources, which are not referenced, and the size of the
+// data, which is no longer embedded when they are removed
+void report_unused_resources(const Settings& settings,
+    const std::vector<Resource>& resources,
+    const std::vector<SymbolFile>& symbol_files) {
+  auto unused = std::vector<const Resource*>();
+  auto used_files = std::vector<CacheKey>();
+  auto count = size_t{ };
+  for (const auto& resource : resources) {
+    if (resource.stub)
+      continue;
+    ++count;
+    if (is_resource_referenced(resource, symbol_files, settings))
+      used_files.push_back(get_cache_key(resource));
+    else
+      unused.push_back(&resource);
   }
+  std::sort(used_files.begin(), used_files.end());
 
+  auto unused_files = std::vector<CacheKey>();
+  auto total_size = size_t{ };
+  std::cout << "unused resources of '" << (settings.config_file.empty() ?
+    std::string("stdin") : path_to_utf8(settings.config_file)) << "':\n";
+  for (const auto* resource : unused) {
+    const auto key = get_cache_key(*resource);
+    const auto size = get_resource_size(*resource);
+    std::cout << "  " << replace_all(resource->id, "/", "::")
+      << " (" << size << " bytes)\n";
+    if (!std::binary_search(used_files.begin(), used_files.end(), key) &&
+        std::find(unused_files.begin(), unused_files.end(), key) ==
+          unused_files.end()) {
+      unused_files.push_back(key);
+      total_size += size;
+    }
+  }
+  std::cout << unused.size() << " of " << count
+    << " resources unused, " << total_size << " bytes\n";
+}
+
+std::vector<Resource> read_resources(const Settings& settings) {
   auto resources = [&]() {
     if (settings.config_file.empty())
-      return read_config(std::cin, std::filesystem::current_path());
-        
+      return read_config(std::cin, std::filesystem::current_path(),
+        settings.defines, settings.stubs);
+
     auto is = std::ifstream(settings.config_file);
     if (!is.good())
       error("opening configuration '" + 
         path_to_utf8(settings.config_file) + "' failed");
-    return read_config(is, settings.config_file.parent_path());
+    return read_config(is, settings.config_file.parent_path(),
+      settings.defines, settings.stubs);
   }();
 
   std::sort(begin(resources), end(resources));
+
+  // ids of excluded resources can be defined in another section
+  auto defined_ids = std::vector<std::string>();
+  for (const auto& resource : resources)
+    if (!resource.stub)
+      defined_ids.push_back(resource.id);
+  resources.erase(std::remove_if(begin(resources), end(resources),
+    [&](const Resource& resource) {
+      return resource.stub && std::binary_search(
+        defined_ids.begin(), defined_ids.end(), resource.id);
+    }), end(resources));
+  resources.erase(std::unique(begin(resources), end(resources),
+    [](const Resource& a, const Resource& b) {
+      return a.stub && b.stub && a.id == b.id;
+    }), end(resources));
+
   auto it = std::adjacent_find(begin(resources), end(resources),
     [](const Resource& a, const Resource& b) { return a.id == b.id; });
   if (it != end(resources))
     error("duplicate id '" + it->id + "'");
+  return resources;
+}
 
-  // update header
-  auto ss = std::ostringstream();
-  generate_output(ss, settings, resources, true);
-  update_textfile(settings.header_file, ss.str());
+// reads the digests declared by existing headers
+std::map<std::string, Digest> read_header_digests(const Settings& settings,
+    const std::vector<std::filesystem::path>& header_files) {
+  const auto fnv1a_type = std::string("constexpr uint64_t ");
+  const auto crc32_type = std::string("constexpr uint32_t ");
+  const auto starts_with = [](const std::string& string,
+      const std::string& prefix) {
+    return (string.rfind(prefix, 0) == 0);
+  };
+  auto digests = std::map<std::string, Digest>();
+  auto declared = std::map<std::string, int>();
+  for (const auto& header_file : header_files) {
+    auto file = std::ifstream(header_file);
+    auto namespaces = std::vector<std::string>();
+    auto line = std::string();
+    while (std::getline(file, line)) {
+      line = trim(line);
+      const auto is_fnv1a = starts_with(line, fnv1a_type);
+      if (starts_with(line, "namespace ") && line.back() == '{') {
+        namespaces.push_back(trim(line.substr(10, line.size() - 11)));
+      }
+      else if (starts_with(line, "} // namespace ")) {
+        if (!namespaces.empty())
+          namespaces.pop_back();
+      }
+      else if (is_fnv1a || starts_with(line, crc32_type)) {
+        // names end with _fnv1a or _crc32
+        const auto equal = line.find(" = ");
+        if (equal == std::string::npos || equal < fnv1a_type.size() + 6)
+          continue;
+        auto id = std::string();
+        for (const auto& name : namespaces)
+          id += name + "/";
+        id += line.substr(fnv1a_type.size(),
+          equal - fnv1a_type.size() - 6);
+        const auto value = std::strtoull(line.c_str() + equal + 3, nullptr, 16);
+        if (is_fnv1a) {
+          digests[id].fnv1a = value;
+          declared[id] |= 1;
+        }
+        else {
+          digests[id].crc32 = ~static_cast<uint32_t>(value);
+          declared[id] |= 2;
+        }
+      }
+    }
+  }
+
+  // only return digests declaring all types
+  const auto types = (settings.digest_fnv1a ? 1 : 0) |
+                     (settings.digest_crc32 ? 2 : 0);
+  for (const auto& [id, declared_types] : declared)
+    if (declared_types != types)
+      digests.erase(id);
+  return digests;
+}
+
+// returns the cache keys of the files used by the resources
+std::vector<CacheKey> get_cache_keys(
+    const std::vector<Resource>& resources) {
+  auto keys = std::vector<CacheKey>();
+  for (const auto& resource : resources)
+    if (!resource.stub)
+      keys.push_back(get_cache_key(resource));
+  std::sort(keys.begin(), keys.end());
+  keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+  return keys;
+}
+
+void generate_outputs(const Settings& settings,
+    const std::vector<Resource>& resources, Cache& cache) {
+  const auto header_files = get_header_files(settings, resources);
+  const auto shards = get_shards(settings, resources);
+
+  // digests are computed while generating the sources, which therefore
+  // needs to precede updating the headers, they are written to temporary
+  // files, which replace the sources afterwards
+  auto sources = std::vector<std::filesystem::path>(shards.size());
+  const auto remove_temporary_sources = [&]() {
+    for (const auto& source : sources)
+      if (!source.empty()) {
+        auto error_code = std::error_code{ };
+        std::filesystem::remove(source, error_code);
+      }
+  };
+  try {
+    if (settings.digest_fnv1a || settings.digest_crc32) {
+      for (auto i = size_t{ }; i < shards.size(); ++i)
+        if (input_files_modified(settings, header_files, shards[i])) {
+          sources[i] = get_temporary_filename(shards[i].source_file);
+          auto os = open_file_for_writing(sources[i]);
+          generate_output(os, settings, shards[i].resources, false, cache);
+        }
+
+      // reuse the digests declared by the headers, unless an input was
+      // modified since the outputs were written
+      auto output_time = std::optional<std::filesystem::file_time_type>();
+      for (const auto& header_file : header_files)
+        output_time = std::max(output_time, get_last_write_time(header_file));
+      for (const auto& shard : shards)
+        output_time = std::max(output_time,
+          get_last_write_time(shard.source_file));
+      const auto config_time = get_last_write_time(settings.config_file);
+      const auto header_digests = (config_time && output_time &&
+        *config_time < *output_time ?
+        read_header_digests(settings, header_files) :
+        std::map<std::string, Digest>());
+
+      for (const auto& resource : resources) {
+        if (settings.stubs && resource.conditional)
+          continue;
+        auto& file = cache[get_cache_key(resource)];
+        if (file.digest)
+          continue;
+        // conditional resources may refer to another file in each variant
+        if (const auto it = header_digests.find(resource.id);
+            it != header_digests.end() && !resource.conditional)
+          if (const auto time = get_last_write_time(resource.path);
+              time && *time < *output_time) {
+            file.digest = it->second;
+            continue;
+          }
+        file.digest = digest_file(resource.path, resource.transforms);
+      }
+    }
+
+    // update headers
+    update_headers(settings, resources, cache);
+  }
+  catch (...) {
+    remove_temporary_sources();
+    throw;
+  }
+
+  // write sources, replaced ones need to be newer than the headers
+  for (auto i = size_t{ }; i < shards.size(); ++i) {
+    if (!sources[i].empty()) {
+      std::filesystem::rename(sources[i], shards[i].source_file);
+      sources[i].clear();
+      std::filesystem::last_write_time(shards[i].source_file,
+        std::filesystem::file_time_type::clock::now());
+    }
+    else if (input_files_modified(settings, header_files, shards[i])) {
+      auto os = open_file_for_writing(shards[i].source_file);
+      generate_output(os, settings, shards[i].resources, false, cache);
+    }
+  }
+
+  if (!settings.depfile.empty())
+    write_depfile(settings, resources);
+}
+
+int main(int argc, const char* argv[]) try {
+  auto settings = Settings();
+  if (!interpret_commandline(settings, argc, argv)) {
+    print_help_message();
+    return 1;
+  }
+
+  const auto trim_cache_when_stored = [&](const Cache& cache) {
+    if (std::any_of(cache.begin(), cache.end(),
+          [](const auto& key_file) { return key_file.second.stored; }))
+      trim_cache(settings);
+  };
+
+  // only report the resources, which are not referenced
+  if (!settings.symbol_files.empty()) {
+    const auto symbol_files = read_symbol_files(settings);
+    if (settings.config_files.size() <= 1)
+      report_unused_resources(settings, read_resources(settings),
+        symbol_files);
+    else
+      for (const auto& config_file : settings.config_files) {
+        auto config_settings = settings;
+        config_settings.config_file = config_file;
+        deduce_output_files(config_settings);
+        report_unused_resources(config_settings,
+          read_resources(config_settings), symbol_files);
+      }
+    return EXIT_SUCCESS;
+  }
+
+  if (settings.config_files.size() <= 1) {
+    auto cache = Cache();
+    generate_outputs(settings, read_resources(settings), cache);
+    trim_cache_when_stored(cache);
+    return EXIT_SUCCESS;
+  }
+
+  // read all configs first, to know which files they share
+  auto batch = std::vector<std::pair<Settings, std::vector<Resource>>>();
+  auto cache = Cache();
+  for (const auto& config_file : settings.config_files) {
+    auto config_settings = settings;
+    config_settings.config_file = config_file;
+    deduce_output_files(config_settings);
+    auto resources = read_resources(config_settings);
+    for (const auto& key : get_cache_keys(resources))
+      ++cache[key].uses;
+    batch.emplace_back(std::move(config_settings), std::move(resources));
+  }
+
+  for (const auto& [config_settings, resources] : batch) {
+    generate_outputs(config_settings, resources, cache);
 
-  // write source
-  if (input_files_modified(settings, resources)) {
-    auto os = open_file_for_writing(settings.source_file);
-    generate_output(os, settings, resources, false);
+    // release hexdumps, which are no longer used
+    for (const auto& key : get_cache_keys(resources))
+      if (auto& file = cache[key]; --file.uses == 0)
+        file.hexdump.reset();
   }
+  trim_cache_when_stored(cache);
   return EXIT_SUCCESS;
 }
 catch (const std::exception& ex) {
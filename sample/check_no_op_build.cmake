@@ -0,0 +1,17 @@
+# builds the sample twice and checks that the second build neither
+# regenerates the resources nor recompiles or relinks anything
+foreach(BUILD first second)
+  execute_process(
+    COMMAND "${CMAKE_COMMAND}" --build "${BINARY_DIR}"
+      --target test-sample --config "${CONFIG}"
+    OUTPUT_VARIABLE OUTPUT
+    ERROR_VARIABLE OUTPUT
+    RESULT_VARIABLE RESULT)
+  if(NOT RESULT EQUAL 0)
+    message(FATAL_ERROR "${BUILD} build failed:\n${OUTPUT}")
+  endif()
+endforeach()
+
+if(OUTPUT MATCHES "Generating resources|Building CXX|Linking CXX")
+  message(FATAL_ERROR "second build was not a no-op:\n${OUTPUT}")
+endif()
@@ -0,0 +1,21 @@
+#if defined(NDEBUG)
+# error "NDEBUG must not be defined"
+#endif
+#include <cassert>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "sample.h"
+
+std::string read_file(const std::string& filename) {
+  auto file = std::ifstream(SAMPLE_SOURCE_DIR "/" + filename,
+    std::ios::in | std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>{ file }, { });
+}
+
+int main() {
+  assert(sample::license == read_file("../LICENSE"));
+  assert(sample::readme == read_file("../README.md"));
+  assert(sample::config == read_file("sample.conf"));
+  std::cout << "Sample test succeeded!" << std::endl;
+}
@@ -98,10 +98,98 @@ void test_parse_definition() {
 
   // normalize id
   assert(check("a::b = c", "a/b", "c", false));
+
+  // transforms
+  const auto transforms = [](const char* definition) {
+    return parse_definition(definition)->transforms;
+  };
+  assert(check("a = b | null-terminate", "a", "b", false));
+  assert(check("a | null-terminate", "a", "a", false));
+  assert(check("a = 'b|c' | null-terminate", "a", "b|c", false));
+  assert(check("[a = b | null-terminate] # x", "a", "b", true));
+  assert(check("[ | null-terminate]", "", "", true));
+  assert(transforms("a = b") == 0);
+  assert(transforms("a = b | null-terminate") == null_terminate);
+  assert(transforms("a = b | normalize-eol, strip-comments") ==
+    (normalize_eol | strip_comments));
+  assert(transforms("[a | minify-json]") == minify_json);
+  assert(check_throws("a = b | invalid"));
+  assert(check_throws("| null-terminate"));
+  assert(check_throws("[a | null-terminate] a"));
+
+  assert(apply_transforms("a\r\nb\rc\n", normalize_eol) == "a\nb\nc\n");
+  assert(apply_transforms("a // b\nc /* d\n */e/**/f '//' \"/*\"",
+    strip_comments) == "a \nc \ne f '//' \"/*\"");
+  assert(apply_transforms("{ \"a b\" : [ 1, \"\\\" \" ] }\n",
+    minify_json) == "{\"a b\":[1,\"\\\" \"]}");
+}
+
+void test_conditional_sections() {
+  const auto directive = [](const char* definition) {
+    return parse_definition(definition)->directive;
+  };
+  const auto condition = [](const char* definition) {
+    return parse_definition(definition)->condition;
+  };
+  const auto check_throws = [](const char* config) {
+    try {
+      auto is = std::istringstream(config);
+      read_config(is, "");
+      return false;
+    }
+    catch (...) {
+      return true;
+    }
+  };
+  const auto read = [](const char* config,
+      const std::vector<std::string>& defines, bool stubs) {
+    auto is = std::istringstream(config);
+    auto ids = std::string();
+    for (const auto& resource : read_config(is, "", defines, stubs))
+      ids += resource.id + (resource.stub ? "* " : " ");
+    return ids;
+  };
+
+  assert(directive("[if a]") == Directive::if_defined);
+  assert(directive(" [ if  !a ] # x") == Directive::if_not_defined);
+  assert(directive("[else]") == Directive::else_branch);
+  assert(directive("[endif]") == Directive::end_if);
+  assert(directive("[ifa]") == Directive::none);
+  assert(directive("[a]") == Directive::none);
+  assert(condition("[if a]") == "a");
+  assert(condition("[if ! a_1 ]") == "a_1");
+  assert(check_throws("[if a b]"));
+  assert(check_throws("[if a::b]"));
+  assert(check_throws("[if 1]"));
+  assert(check_throws("[endif] a"));
+  assert(check_throws("[if a]"));
+  assert(check_throws("[endif]"));
+  assert(check_throws("[else]"));
+  assert(check_throws("[if a]\n[else]\n[else]\n[endif]"));
+
+  const auto config = R"(
+    a
+    [if x]
+    b
+    [if !y]
+    c
+    [else]
+    d
+    [endif]
+    [else]
+    e
+    [endif]
+    f
+  )";
+  assert(read(config, { }, false) == "a e f ");
+  assert(read(config, { "x" }, false) == "a b c f ");
+  assert(read(config, { "x", "y" }, false) == "a b d f ");
+  assert(read(config, { "y" }, true) == "a b* c* d* e f ");
 }
 
 const auto res1 = std::string("0123456789");
 const auto res2 = std::string("abcdefghijklmnopqrstuvwxyz");
+const auto res_json = std::string("{\r\n  \"a\": 1, // comment\r\n  \"b\": \"c d\"\r\n}\r\n");
 
 #if defined(TEST_GENERATE)
 
@@ -114,8 +202,151 @@ void res2cpp(const std::string& arguments) {
   assert(result == 0);
 }
 
+// generates configs for all combinations of encoding settings and output
+// modes and the source, which verifies their embedded data
+void generate_matrix() {
+  std::filesystem::remove_all("matrix");
+
+  auto random = std::mt19937(1);
+  const auto random_data = [&](size_t size, int zero_percent) {
+    auto data = std::string(size, ' ');
+    for (auto& c : data)
+      c = static_cast<char>(static_cast<int>(random() % 100) < zero_percent ?
+        0 : random() % 256);
+    return data;
+  };
+  auto files = std::vector<std::pair<std::string, std::string>>();
+  files.emplace_back("empty", "");
+  files.emplace_back("random", random_data(1000, 0));
+  files.emplace_back("zeros", random_data(1000, 95));
+  auto text = std::string();
+  for (auto i = 0; i < 40; ++i)
+    text += "line " + std::to_string(i) + " of some text\r\n";
+  files.emplace_back("text", text);
+  for (auto size = 1; size <= 17; ++size)
+    files.emplace_back("tail_" + std::to_string(size),
+      random_data(static_cast<size_t>(size), 0));
+  // crosses the blocks of the encoder, which do not end on a key boundary,
+  // only used by some configs, to keep the size of the generated sources
+  const auto large = std::make_pair(std::string("large"),
+    random_data(2 * 65536 + 5, 0));
+  for (const auto& [name, data] : files)
+    write_textfile("matrix/files/" + name + ".bin", data);
+  write_textfile("matrix/files/" + large.first + ".bin", large.second);
+
+  const auto encodings = { "", "-n", "-p" };
+  const auto keys = { "", "k3y" };
+  const auto data_types = { "unsigned char", "char", "uint8_t",
+    "std::byte", "void" };
+  const auto modes = { "", "-g", "-j 3", "-k fnv1a -k crc32",
+    "-C matrix/cache", "-r", "-R", "-z -D variant", "batch",
+    "null-terminate" };
+
+  auto includes = std::string();
+  auto checks = std::string();
+  auto big_endian_includes = std::string();
+  auto big_endian_checks = std::string();
+  auto index = 0;
+  for (const auto& encoding : encodings)
+    for (const auto& key : keys)
+      for (const auto& data_type : data_types)
+        for (const auto& mode : modes) {
+          const auto name = "matrix_" + std::to_string(index++);
+          const auto null_terminated = (mode == std::string("null-terminate"));
+          const auto batch = (mode == std::string("batch"));
+          const auto variant = (mode == std::string("-z -D variant"));
+          const auto big_endian = (encoding == std::string("-p") &&
+            mode != std::string("-r"));
+          auto config_files = files;
+          if (data_type == std::string("unsigned char") &&
+              (!*mode || null_terminated || batch ||
+               mode == std::string("-k fnv1a -k crc32") ||
+               mode == std::string("-C matrix/cache")))
+            config_files.push_back(large);
+
+          // a batch shares all files with a second config
+          auto config_names = std::vector<std::string>{ name };
+          if (batch)
+            config_names.push_back(name + "_b");
+          for (const auto& config_name : config_names) {
+            auto config = "[" + config_name + " = files" +
+              (null_terminated ? " | null-terminate]\n" : "]\n");
+            if (variant)
+              config += "[if variant]\n";
+            for (const auto& file : config_files)
+              config += file.first + ".bin\n";
+            if (variant)
+              config += "[endif]\n"
+                "[if !variant]\nexcluded = text.bin\n[endif]\n";
+            write_textfile("matrix/" + config_name + ".conf", config);
+          }
+
+          auto arguments = std::string(encoding) +
+            " -d \"" + data_type + "\"";
+          if (batch) {
+            write_textfile("matrix/" + name + ".batch",
+              name + ".conf\n" + name + "_b.conf\n");
+            arguments += " -b matrix/" + name + ".batch";
+          }
+          else {
+            arguments += " -c matrix/" + name + ".conf";
+          }
+          if (*key)
+            arguments += " -x " + std::string(key);
+          if (!null_terminated && !batch)
+            arguments += " " + std::string(mode);
+          res2cpp(arguments);
+
+          if (mode == std::string("-C matrix/cache")) {
+            // generate again from cache
+            std::filesystem::remove("matrix/" + name + ".cpp");
+            res2cpp(arguments);
+          }
+
+          auto config_includes = std::string();
+          if (mode == std::string("-j 3")) {
+            for (auto i = 0; i < 3; ++i)
+              config_includes += "#include \"matrix/" + name + "_" +
+                std::to_string(i) + ".cpp\"\n";
+          }
+          else {
+            for (const auto& config_name : config_names)
+              config_includes += "#include \"matrix/" + config_name +
+                ".cpp\"\n";
+          }
+          includes += config_includes;
+          if (big_endian)
+            big_endian_includes += config_includes;
+
+          for (const auto& config_name : config_names) {
+            for (const auto& file : config_files) {
+              const auto id = config_name + "::" + file.first;
+              const auto arguments = "(" + id + ", \"" + file.first +
+                "\", \"" + key + "\", " +
+                (null_terminated ? "true" : "false") + "));\n";
+              checks += "  assert(check_matrix" + arguments;
+              if (big_endian)
+                big_endian_checks += "  assert(check_matrix_big_endian" +
+                  arguments;
+              if (mode == std::string("-k fnv1a -k crc32"))
+                checks += "  assert(check_matrix_digest(" + id + "_fnv1a, " +
+                  id + "_crc32, \"" + file.first + "\"));\n";
+            }
+            if (variant)
+              checks += "  assert(!" + config_name + "::excluded.first && " +
+                config_name + "::excluded.second == 0);\n";
+          }
+        }
+
+  write_textfile("matrix.inc", includes +
+    "\nvoid verify_matrix() {\n" + checks + "}\n");
+  write_textfile("matrix_big_endian.inc", big_endian_includes +
+    "\nvoid verify_matrix_big_endian() {\n" + big_endian_checks + "}\n");
+}
+
 int main() {
   test_parse_definition();
+  test_conditional_sections();
 
   // config1
   write_textfile("config1/res1.txt", res1);
@@ -180,21 +411,371 @@ int main() {
   )";
   write_textfile("config4.conf", config4);
   res2cpp("-x sEcurepa55 -c config4.conf");
+
+  // config5
+  write_textfile("config5/res1.txt", res1);
+  write_textfile("config5/res2.txt", res2);
+  const auto config5 = R"(
+    [ = config5]
+    a::res1 = res1.txt
+    b::res2 = res2.txt
+    res3 = res2.txt
+  )";
+  write_textfile("config5.conf", config5);
+  res2cpp("-g -d char -c config5.conf");
+
+  // group headers, which are no longer generated, are removed
+  write_textfile("config5b.conf",
+    "[ = config5]\nc::res1 = res1.txt\nd::res2 = res2.txt\n");
+  res2cpp("-g -c config5b.conf");
+  assert(std::filesystem::exists("config5b_c.h"));
+  assert(std::filesystem::exists("config5b_d.h"));
+  write_textfile("config5b.conf", "[ = config5]\nc::res1 = res1.txt\n");
+  res2cpp("-g -c config5b.conf");
+  assert(std::filesystem::exists("config5b_c.h"));
+  assert(!std::filesystem::exists("config5b_d.h"));
+  res2cpp("-c config5b.conf");
+  assert(!std::filesystem::exists("config5b_c.h"));
+
+  // config6
+  write_textfile("config6/res1.txt", res1);
+  write_textfile("config6/res2.txt", res2);
+  const auto config6 = R"(
+    [config6]
+    res1.txt
+    res2.txt
+  )";
+  write_textfile("config6.conf", config6);
+  res2cpp("-k fnv1a -k crc32 -x sEcurepa55 -c config6.conf");
+
+  // digests are reused, unless a resource was modified
+  write_textfile("config6b.conf", "[config6b = config6]\nres1.txt\n");
+  res2cpp("-k fnv1a -k crc32 -c config6b.conf");
+  const auto config6b_h = read_textfile("config6b.h");
+  const auto fnv1a = std::string("0x50C0AAFD8B4330B2ULL");
+  assert(config6b_h.find(fnv1a) != std::string::npos);
+  write_textfile("config6b.h",
+    replace_all(config6b_h, fnv1a, "0x0000000000000001ULL"));
+  write_textfile("config6b.cpp", read_textfile("config6b.cpp"));
+  const auto past = std::filesystem::file_time_type::clock::now() -
+    std::chrono::seconds(10);
+  std::filesystem::last_write_time("config6b.conf", past);
+  std::filesystem::last_write_time("config6/res1.txt", past);
+  res2cpp("-k fnv1a -k crc32 -c config6b.conf");
+  assert(read_textfile("config6b.h").find(fnv1a) == std::string::npos);
+  write_textfile("config6/res1.txt", res1);
+  res2cpp("-k fnv1a -k crc32 -c config6b.conf");
+  assert(read_textfile("config6b.h") == config6b_h);
+
+  // config7, outputs of batch and separate runs are identical
+  write_textfile("config7/res1.txt", res1);
+  write_textfile("config7/res2.txt", res2);
+  const auto config7a = R"(
+    [config7a = config7]
+    res1.txt
+    res2.txt
+  )";
+  const auto config7b = R"(
+    [config7b = config7]
+    res2.txt
+  )";
+  write_textfile("config7a.conf", config7a);
+  write_textfile("config7b.conf", config7b);
+  write_textfile("config7.batch", "config7a.conf\n# comment\nconfig7b.conf\n");
+  res2cpp("-k fnv1a -c config7a.conf -c config7b.conf");
+  const auto config7a_cpp = read_textfile("config7a.cpp");
+  const auto config7b_cpp = read_textfile("config7b.cpp");
+  const auto config7b_h = read_textfile("config7b.h");
+  std::filesystem::remove("config7a.cpp");
+  std::filesystem::remove("config7b.cpp");
+  std::filesystem::remove("config7b.h");
+  res2cpp("-k fnv1a -c config7a.conf");
+  res2cpp("-k fnv1a -c config7b.conf");
+  assert(read_textfile("config7a.cpp") == config7a_cpp);
+  assert(read_textfile("config7b.cpp") == config7b_cpp);
+  assert(read_textfile("config7b.h") == config7b_h);
+  std::filesystem::remove("config7b.cpp");
+  res2cpp("-k fnv1a -b config7.batch");
+  assert(read_textfile("config7b.cpp") == config7b_cpp);
+
+  // config8
+  write_textfile("config8/res1.txt", res1);
+  write_textfile("config8/res3.json", res_json);
+  const auto config8 = R"(
+    [config8 | null-terminate]
+    res1.txt
+    res1_copy = res1.txt | normalize-eol
+    res3 = res3.json
+    res3_eol = res3.json | normalize-eol
+    res3_min = res3.json | strip-comments, minify-json
+  )";
+  write_textfile("config8.conf", config8);
+  res2cpp("-n -d char -x sEcurepa55 -k fnv1a -c config8.conf");
+
+  // config9, outputs with and without cache are identical
+  const auto count_files = [](const std::filesystem::path& directory) {
+    auto count = 0;
+    for (const auto& entry :
+         std::filesystem::recursive_directory_iterator(directory))
+      count += (entry.is_regular_file() ? 1 : 0);
+    return count;
+  };
+  std::filesystem::remove_all("config9_cache");
+  write_textfile("config9/res1.txt", res1);
+  write_textfile("config9/res2.txt", res2);
+  const auto config9 = R"(
+    [config9 | null-terminate]
+    res1.txt
+    res2.txt
+    res2_eol = res2.txt | normalize-eol
+  )";
+  write_textfile("config9.conf", config9);
+  res2cpp("-k crc32 -x sEcurepa55 -c config9.conf");
+  const auto config9_cpp = read_textfile("config9.cpp");
+  const auto config9_h = read_textfile("config9.h");
+  std::filesystem::remove("config9.cpp");
+  res2cpp("-k crc32 -x sEcurepa55 -C config9_cache -c config9.conf");
+  assert(read_textfile("config9.cpp") == config9_cpp);
+  assert(count_files("config9_cache") == 3);
+  std::filesystem::remove("config9.cpp");
+  std::filesystem::remove("config9.h");
+  res2cpp("-k crc32 -x sEcurepa55 -C config9_cache -c config9.conf");
+  assert(read_textfile("config9.cpp") == config9_cpp);
+  assert(read_textfile("config9.h") == config9_h);
+  std::filesystem::remove("config9.cpp");
+  res2cpp("-k crc32 -C config9_cache -M 0 -c config9.conf");
+  assert(count_files("config9_cache") == 0);
+  res2cpp("-k crc32 -x sEcurepa55 -C config9_cache -c config9.conf");
+  assert(read_textfile("config9.cpp") == config9_cpp);
+
+  // config10, header is identical in dev mode
+  write_textfile("config10/res1.txt", res1);
+  write_textfile("config10/res2.txt", res2);
+  write_textfile("config10/empty.txt", "");
+  const auto config10 = R"(
+    [config10]
+    res1.txt
+    res2.txt
+    empty.txt
+    res2_copy = res2.txt
+    res2_null = res2.txt | null-terminate
+  )";
+  write_textfile("config10.conf", config10);
+  res2cpp("-d char -c config10.conf");
+  const auto config10_h = read_textfile("config10.h");
+  res2cpp("-r -d char -c config10.conf");
+  assert(read_textfile("config10.h") == config10_h);
+  assert(read_textfile("config10.cpp").find("res2cpp_load_file") !=
+    std::string::npos);
+
+  // config11, report of resources, which are not referenced
+  write_textfile("config11/res1.txt", res1);
+  write_textfile("config11/res2.txt", res2);
+  const auto config11 = R"(
+    [config11]
+    res1.txt
+    res2.txt
+    a::res3 = res2.txt
+  )";
+  write_textfile("config11.conf", config11);
+  write_textfile("config11.map",
+    "Discarded input sections\n"
+    " .data.rel.ro._ZN8config114res2E\n"
+    "Memory Configuration\n"
+    " .data.rel.ro._ZN8config111a4res3E\n");
+  write_textfile("config11_main.obj",
+    std::string("\0?res1@config11@@3U?$pair@PBEI@std@@B\0", 38));
+  write_textfile("config11.cpp.o",
+    std::string("\0_ZN8config114res2E\0", 20));
+  res2cpp("-c config11.conf -u config11.map -u config11_main.obj "
+    "-u config11.cpp.o > config11_unused.txt");
+  assert(read_textfile("config11_unused.txt") ==
+    "unused resources of 'config11.conf':\n"
+    "  config11::res2 (26 bytes)\n"
+    "1 of 3 resources unused, 0 bytes\n");
+  assert(!std::filesystem::exists("config11.cpp"));
+
+  // config12, header is identical for all variants with stubs
+  write_textfile("config12/res1.txt", res1);
+  write_textfile("config12/res2.txt", res2);
+  const auto config12 = R"(
+    [config12]
+    res1.txt
+    [if hd]
+    image = res2.txt
+    hd_only = res2.txt
+    [else]
+    image = res1.txt
+    [endif]
+    [if !hd]
+    sd_only = res1.txt
+    [endif]
+  )";
+  write_textfile("config12.conf", config12);
+  res2cpp("-z -D hd -d char -k fnv1a -c config12.conf");
+  const auto config12_h = read_textfile("config12.h");
+  const auto config12_cpp = read_textfile("config12.cpp");
+  res2cpp("-z -d char -k fnv1a -c config12.conf");
+  assert(read_textfile("config12.h") == config12_h);
+  assert(config12_h.find("res1_fnv1a") != std::string::npos);
+  assert(config12_h.find("image_fnv1a") == std::string::npos);
+  assert(read_textfile("config12.cpp") != config12_cpp);
+
+  // sources are regenerated, even when no stubs are defined
+  const auto config12b = R"(
+    [config12b = config12]
+    [if hd]
+    image = res2.txt
+    [else]
+    image = res1.txt
+    [endif]
+  )";
+  write_textfile("config12b.conf", config12b);
+  res2cpp("-D hd -c config12b.conf");
+  const auto config12b_h = read_textfile("config12b.h");
+  const auto config12b_cpp = read_textfile("config12b.cpp");
+  res2cpp("-c config12b.conf");
+  assert(read_textfile("config12b.h") == config12b_h);
+  assert(read_textfile("config12b.cpp") != config12b_cpp);
+
+  // digests of conditional resources are not reused from other variants
+  const auto config12b_dev = "-r -k fnv1a -h config12b_dev.h "
+    "-s config12b_dev.cpp -c config12b.conf";
+  res2cpp(std::string("-D hd ") + config12b_dev);
+  assert(read_textfile("config12b_dev.h").find(fnv1a) == std::string::npos);
+  std::filesystem::last_write_time("config12b.conf", past);
+  std::filesystem::last_write_time("config12/res1.txt", past);
+  std::filesystem::last_write_time("config12/res2.txt", past);
+  res2cpp(config12b_dev);
+  assert(read_textfile("config12b_dev.h").find(fnv1a) != std::string::npos);
+
+  // config13, relocatable outputs are identical in every directory
+  const auto config13 = R"(
+    [config13 = res]
+    res1.txt
+    [if hd]
+    res2.txt
+    [endif]
+  )";
+  for (const auto directory : { "config13a/", "config13b/" }) {
+    std::filesystem::remove_all(directory);
+    write_textfile(directory + std::string("config13.conf"), config13);
+    write_textfile(directory + std::string("res/res1.txt"), res1);
+    write_textfile(directory + std::string("res/res2.txt"), res2);
+  }
+  const auto options = std::string("-R -z -g -j 2 -k fnv1a -d char ");
+  res2cpp(options + "-c config13a/config13.conf "
+    "-s config13a/src/config13.cpp -h config13a/include/config13.h");
+  const auto config13b = path_to_utf8(std::filesystem::absolute("config13b"));
+  res2cpp(options + "-c \"" + config13b + "/config13.conf\" "
+    "-s \"" + config13b + "/src/config13.cpp\" "
+    "-h \"" + config13b + "/include/config13.h\"");
+  auto config13_files = 0;
+  for (const auto& entry :
+       std::filesystem::recursive_directory_iterator("config13a")) {
+    const auto relative = entry.path().lexically_relative("config13a");
+    if (!entry.is_regular_file() || relative.begin()->string() == "res")
+      continue;
+    assert(read_textfile(entry.path()) ==
+      read_textfile("config13b" / relative));
+    ++config13_files;
+  }
+  assert(config13_files == 5);
+
+  generate_matrix();
+}
+
+#elif defined(TEST_BIG_ENDIAN)
+
+// compare embedded words with the big endian words of the original file
+template<typename Resource>
+bool check_matrix_big_endian(const Resource& resource,
+    const std::string& name, std::string_view key, bool null_terminated) {
+  auto expected = read_textfile(TEST_DIRECTORY "/matrix/files/" +
+    name + ".bin");
+  if (expected.size() != resource.second)
+    return false;
+  if (null_terminated)
+    expected.push_back('\0');
+
+  // the padding is encoded as well, an empty file is a single zero word
+  expected.resize((expected.size() + 7) / 8 * 8);
+  if (!key.empty())
+    for (auto i = size_t{ }; i < expected.size(); ++i)
+      expected[i] ^= key[i % key.size()];
+  if (expected.empty())
+    expected.resize(8);
+
+  const auto words = static_cast<const uint64_t*>(
+    static_cast<const void*>(resource.first));
+  for (auto i = size_t{ }; i < expected.size(); ++i)
+    if (static_cast<uint8_t>(words[i / 8] >> (8 * (7 - i % 8))) !=
+        static_cast<uint8_t>(expected[i]))
+      return false;
+  return true;
 }
 
-#else // !TEST_GENERATE
+#include "matrix_big_endian.inc"
+
+int main() {
+  verify_matrix_big_endian();
+
+  std::cout << "All tests succeeded!" << std::endl;
+}
+
+#else // !TEST_GENERATE && !TEST_BIG_ENDIAN
 
 #include "config1.cpp"
 #include "config2/source/file.cpp"
 #include "config3.cpp"
 #include "config4.cpp"
+#include "config5_a.h"
+#include "config5.cpp"
+#include "config6.cpp"
+#include "config7a.cpp"
+#include "config7b.cpp"
+#include "config8.cpp"
+#include "config9.cpp"
+#include "config10.cpp"
+#include "config12.cpp"
+#include "config13a/src/config13_0.cpp"
+#include "config13a/src/config13_1.cpp"
 
-template<typename T>
-std::vector<T> xor_cipher(const T* data, size_t size, std::string_view key) {
-  std::vector<T> decoded(size, T{ });
-  if (!key.empty())
-    for (size_t i = 0; i < size; ++i)
-      decoded[i] = data[i] ^ static_cast<T>(key[i % key.size()]);
+// compare embedded data with the original file
+template<typename Resource>
+bool check_matrix(const Resource& resource, const std::string& name,
+    std::string_view key, bool null_terminated) {
+  const auto expected = read_textfile(TEST_DIRECTORY "/matrix/files/" +
+    name + ".bin");
+  const auto size = resource.second + (null_terminated ? 1 : 0);
+  auto data = std::string(size, ' ');
+  if (size)
+    res2cpp::xor_decode(resource.first, 0, size, data.data(), key);
+  if (null_terminated && data.back() != '\0')
+    return false;
+  data.resize(resource.second);
+  return (data == expected);
+}
+
+bool check_matrix_digest(uint64_t fnv1a, uint32_t crc32,
+    const std::string& name) {
+  const auto expected = read_textfile(TEST_DIRECTORY "/matrix/files/" +
+    name + ".bin");
+  auto digest = Digest{ };
+  update_digest(digest, expected.data(), expected.size());
+  return (digest.fnv1a == fnv1a && ~digest.crc32 == crc32);
+}
+
+#include "matrix.inc"
+
+// decode in chunks of varying size
+std::string xor_decode(const void* data, size_t size, std::string_view key) {
+  auto decoded = std::string(size, ' ');
+  for (auto offset = size_t{ }, chunk = size_t{ 1 }; offset < size; ++chunk) {
+    chunk = std::min(chunk, size - offset);
+    res2cpp::xor_decode(data, offset, chunk, &decoded[offset], key);
+    offset += chunk;
+  }
   return decoded;
 }
 
@@ -215,14 +796,73 @@ int main() {
 
   // config4
   const auto key = std::string("sEcurepa55");
-  const auto res4_1 = xor_cipher(config4::res1.first, config4::res1.second, key);
-  const auto res4_2 = xor_cipher(config4::res2.first, config4::res2.second, key);
-  assert(res1 == std::string_view(
-    reinterpret_cast<const char*>(res4_1.data()), res4_1.size()));
+  assert(res1 == xor_decode(config4::res1.first, config4::res1.second, key));
+  assert(res2 == xor_decode(config4::res2.first, config4::res2.second, key));
+
+  // config5
+  assert(res1 == std::string_view(a::res1.first, a::res1.second));
+  assert(res2 == std::string_view(b::res2.first, b::res2.second));
+  assert(res2 == std::string_view(res3.first, res3.second));
+
+  // config6
+  static_assert(config6::res1_fnv1a == 0x50C0AAFD8B4330B2ULL);
+  static_assert(config6::res1_crc32 == 0xA684C7C6);
+  static_assert(config6::res2_fnv1a != config6::res1_fnv1a);
+  auto res6_2 = std::string(config6::res2.second, ' ');
+  res2cpp::xor_decode(config6::res2.first, 0, res6_2.size(), res6_2.data(), key);
+  assert(res2 == res6_2);
+
+  // config7
   assert(res2 == std::string_view(
-    reinterpret_cast<const char*>(res4_2.data()), res4_2.size()));
+    reinterpret_cast<const char*>(config7b::res2.first), config7b::res2.second));
+  static_assert(config7a::res2_fnv1a == config7b::res2_fnv1a);
+
+  // config8
+  const auto check_null_terminated = [&](const auto& resource,
+      std::string_view expected) {
+    const auto data = xor_decode(resource.first, resource.second + 1, key);
+    return (data.size() == expected.size() + 1 && data.back() == '\0' &&
+            std::string_view(data.data(), data.size() - 1) == expected);
+  };
+  assert(check_null_terminated(config8::res1, res1));
+  assert(check_null_terminated(config8::res1_copy, res1));
+  assert(check_null_terminated(config8::res3, res_json));
+  assert(check_null_terminated(config8::res3_eol,
+    "{\n  \"a\": 1, // comment\n  \"b\": \"c d\"\n}\n"));
+  assert(check_null_terminated(config8::res3_min, "{\"a\":1,\"b\":\"c d\"}"));
+  static_assert(config8::res1_fnv1a == 0x50C0AAFD8B4330B2ULL);
+
+  // config9
+  assert(res2 == xor_decode(config9::res2.first, config9::res2.second, key));
+  static_assert(config9::res1_crc32 == 0xA684C7C6);
+
+  // config10
+  assert(res1 == std::string_view(config10::res1.first, config10::res1.second));
+  assert(res2 == std::string_view(config10::res2.first, config10::res2.second));
+  assert(config10::res2_copy.first == config10::res2.first);
+  assert(config10::empty.second == 0);
+  assert(res2 == config10::res2_null.first);
+  {
+    // the content is loaded at startup, truncating the file does not
+    // affect the program
+    const auto filename = TEST_DIRECTORY "/config10/res1.txt";
+    write_textfile(filename, "");
+    assert(res1 == std::string_view(config10::res1.first, config10::res1.second));
+    write_textfile(filename, res1);
+  }
+
+  // config12
+  assert(res1 == std::string_view(config12::image.first, config12::image.second));
+  assert(res1 == std::string_view(config12::sd_only.first, config12::sd_only.second));
+  assert(!config12::hd_only.first && config12::hd_only.second == 0);
+
+  // config13
+  assert(res1 == std::string_view(config13::res1.first, config13::res1.second));
+  assert(!config13::res2.first && config13::res2.second == 0);
+
+  verify_matrix();
 
   std::cout << "All tests succeeded!" << std::endl;
 }
 
-#endif // !TEST_GENERATE
+#endif // !TEST_GENERATE && !TEST_BIG_ENDIAN